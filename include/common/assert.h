@@ -15,6 +15,9 @@
 #include <common/config.h>
 #include <hedley/hedley.h>
 
+#include <cstddef>  // for std::nullptr_t
+#include <type_traits>
+
 /*!
  * @def ASAP_UNREACHABLE()
  * @hideinitializer
@@ -53,6 +56,43 @@
  */
 #define ASAP_UNREACHABLE() HEDLEY_UNREACHABLE()
 
+/*!
+ * @name Assertion levels
+ *
+ * The assertion macros are enabled according to the assertion level:
+ *   - ASAP_ASSERT_LEVEL_OFF: no check at all, and ASAP_ASSUME() becomes an
+ *     optimizer hint;
+ *   - ASAP_ASSERT_LEVEL_DEFAULT: all the assertion macros but
+ *     ASAP_ASSERT_AUDIT();
+ *   - ASAP_ASSERT_LEVEL_AUDIT: all the assertion macros.
+ *
+ * The level of the build is set with the ASAP_ASSERT_LEVEL CMake cache
+ * variable (off, default or audit), and is off if ASAP_USE_ASSERTS is OFF. A
+ * translation unit can use another level by defining ASAP_ASSERT_LEVEL before
+ * including this header:
+ *
+ * @code
+ * #define ASAP_ASSERT_LEVEL ASAP_ASSERT_LEVEL_AUDIT
+ * #include <common/assert.h>
+ * @endcode
+ *
+ * Failed assertions are only reported if the library itself was built with
+ * ASAP_USE_ASSERTS.
+ */
+///@{
+#define ASAP_ASSERT_LEVEL_OFF 0
+#define ASAP_ASSERT_LEVEL_DEFAULT 1
+#define ASAP_ASSERT_LEVEL_AUDIT 2
+
+#if !defined(ASAP_ASSERT_LEVEL)
+#if ASAP_USE_ASSERTS
+#define ASAP_ASSERT_LEVEL ASAP_ASSERT_BUILD_LEVEL
+#else
+#define ASAP_ASSERT_LEVEL ASAP_ASSERT_LEVEL_OFF
+#endif
+#endif
+///@}
+
 /// @cond (INTERNAL_DETAIL)
 // clang-format off
 #if defined(HEDLEY_GCC_VERSION)
@@ -60,6 +100,12 @@
 #else
 # define ASAP_FUNCTION __FUNCTION__
 #endif
+// Failure paths are kept out of line, and out of the way of the hot code.
+#if HEDLEY_HAS_ATTRIBUTE(cold)
+# define ASAP_COLD HEDLEY_NEVER_INLINE __attribute__((__cold__))
+#else
+# define ASAP_COLD HEDLEY_NEVER_INLINE
+#endif
 // clang-format on
 /// @endcond (INTERNAL_DETAIL)
 
@@ -80,25 +126,124 @@ namespace asap {
  * @param kind if 1, indicates a precondition that failed, otherwise it's a
  * general assertion.
  */
-void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
-                                 char const *function, char const *val,
-                                 int kind = 0);
+ASAP_COLD void ASAP_COMMON_API assert_fail(const char *expr, int line,
+                                           char const *file,
+                                           char const *function,
+                                           char const *val, int kind = 0);
 
-}  // namespace asap
+/*!
+ * @brief Make a failed assertion also report the stacks of all the other
+ * threads of the process.
+ *
+ * Whatever this setting, only the first thread to fail an assertion reports
+ * it and aborts the process; threads failing an assertion after it wait for
+ * the abort, so that the reports do not interleave.
+ *
+ * When enabled, the failing thread first sends signal SIGRTMAX - 1 to every
+ * other thread of the process, whose handler captures the stack of the thread
+ * into a preallocated report, and waits up to a second for the answers. The
+ * stacks are printed after the report of the failed assertion. Threads
+ * blocking the signal do not answer.
+ *
+ * Only supported on Linux with execinfo.h; does nothing elsewhere.
+ */
+void ASAP_COMMON_API set_assert_thread_dump(bool enabled);
 
-#if ASAP_USE_ASSERTS || defined(DOXYGEN_DOCUMENTATION_BUILD)
+/// @cond (INTERNAL_DETAIL)
+namespace details {
 
-#if ASAP_USE_SYSTEM_ASSERTS && !defined(DOXYGEN_DOCUMENTATION_BUILD)
+// Failure handlers of ASAP_ASSERT_VAL and ASAP_ASSERT_FAIL_VAL. They format
+// `name: value` with snprintf() and call assert_fail(), so that a call site
+// only holds the check and a call.
+ASAP_COLD void ASAP_COMMON_API assert_fail_val(char const *expr, int line,
+                                               char const *file,
+                                               char const *function,
+                                               char const *name, bool value);
+ASAP_COLD void ASAP_COMMON_API assert_fail_val(char const *expr, int line,
+                                               char const *file,
+                                               char const *function,
+                                               char const *name, char value);
+ASAP_COLD void ASAP_COMMON_API
+assert_fail_val(char const *expr, int line, char const *file,
+                char const *function, char const *name, long long value);
+ASAP_COLD void ASAP_COMMON_API assert_fail_val(char const *expr, int line,
+                                               char const *file,
+                                               char const *function,
+                                               char const *name,
+                                               unsigned long long value);
+ASAP_COLD void ASAP_COMMON_API
+assert_fail_val(char const *expr, int line, char const *file,
+                char const *function, char const *name, double value);
+ASAP_COLD void ASAP_COMMON_API
+assert_fail_val(char const *expr, int line, char const *file,
+                char const *function, char const *name, char const *value);
+ASAP_COLD void ASAP_COMMON_API
+assert_fail_val(char const *expr, int line, char const *file,
+                char const *function, char const *name, void const *value);
 
-#include <cassert>
-#define ASAP_ASSERT(a) assert(a)
-#define ASAP_ASSERT_PRECOND(a) assert(a)
-#define ASAP_ASSERT_VAL(a, x) assert(a)
-#define ASAP_ASSERT_FAIL() assert(false)
-#define ASAP_ASSERT_FAIL_VAL(x) assert(false)
+// The value checked by an assertion, converted to one of the types printed by
+// the failure handlers: booleans, characters, integers, floating point
+// numbers, enumerations (as their underlying value), NUL terminated strings,
+// strings with a c_str() member, and pointers.
 
-#else  // !ASAP_USE_SYSTEM_ASSERTS
-#include <sstream>
+inline auto assert_value(bool value) -> bool { return value; }
+inline auto assert_value(char value) -> char { return value; }
+inline auto assert_value(char const *value) -> char const * { return value; }
+inline auto assert_value(std::nullptr_t /*value*/) -> void const * {
+  return nullptr;
+}
+
+template <typename T>
+using is_assert_integer =
+    std::integral_constant<bool, std::is_integral<T>::value &&
+                                     !std::is_same<T, bool>::value &&
+                                     !std::is_same<T, char>::value>;
+
+template <typename T, typename std::enable_if<is_assert_integer<T>::value &&
+                                                  std::is_signed<T>::value,
+                                              int>::type = 0>
+auto assert_value(T value) -> long long {
+  return value;
+}
+
+template <typename T, typename std::enable_if<is_assert_integer<T>::value &&
+                                                  std::is_unsigned<T>::value,
+                                              int>::type = 0>
+auto assert_value(T value) -> unsigned long long {
+  return value;
+}
+
+template <typename T, typename std::enable_if<
+                          std::is_floating_point<T>::value, int>::type = 0>
+auto assert_value(T value) -> double {
+  return static_cast<double>(value);
+}
+
+template <typename T,
+          typename std::enable_if<
+              !std::is_same<typename std::remove_cv<T>::type, char>::value,
+              int>::type = 0>
+auto assert_value(T *value) -> void const * {
+  return value;
+}
+
+template <typename T>
+auto assert_value(T const &value) -> decltype(assert_value(value.c_str())) {
+  return value.c_str();
+}
+
+template <typename T,
+          typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+auto assert_value(T value) -> decltype(assert_value(
+    static_cast<typename std::underlying_type<T>::type>(value))) {
+  return assert_value(
+      static_cast<typename std::underlying_type<T>::type>(value));
+}
+
+}  // namespace details
+/// @endcond (INTERNAL_DETAIL)
+
+}  // namespace asap
 
 /// @cond (INTERNAL_DETAIL)
 // This is to disable the warning of conditional expressions being constant
@@ -116,6 +261,21 @@ void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
 // clang-format on
 /// @endcond (INTERNAL_DETAIL)
 
+#if ASAP_ASSERT_LEVEL >= ASAP_ASSERT_LEVEL_DEFAULT || \
+    defined(DOXYGEN_DOCUMENTATION_BUILD)
+
+#if ASAP_USE_SYSTEM_ASSERTS && !defined(DOXYGEN_DOCUMENTATION_BUILD)
+
+#include <cassert>
+#define ASAP_ASSERT(a) assert(a)
+#define ASAP_ASSERT_PRECOND(a) assert(a)
+#define ASAP_ASSERT_VAL(a, x) assert(a)
+#define ASAP_ASSERT_FAIL() assert(false)
+#define ASAP_ASSERT_FAIL_VAL(x) assert(false)
+#define ASAP_ASSUME(a) assert(a)
+
+#else  // !ASAP_USE_SYSTEM_ASSERTS
+
 /*!
  * @hideinitializer
  * @brief Check the expression \em a and if it evaluates to 0 print an
@@ -123,7 +283,7 @@ void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
  */
 #define ASAP_ASSERT(a)                                                      \
   do {                                                                      \
-    if (a) {                                                                \
+    if (HEDLEY_LIKELY(a)) {                                                 \
     } else                                                                  \
       asap::assert_fail(#a, __LINE__, __FILE__, ASAP_FUNCTION, nullptr, 0); \
   }                                                                         \
@@ -140,7 +300,7 @@ void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
  */
 #define ASAP_ASSERT_PRECOND(a)                                              \
   do {                                                                      \
-    if (a) {                                                                \
+    if (HEDLEY_LIKELY(a)) {                                                 \
     } else                                                                  \
       asap::assert_fail(#a, __LINE__, __FILE__, ASAP_FUNCTION, nullptr, 1); \
   }                                                                         \
@@ -151,17 +311,17 @@ void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
  * @brief Check the expression \em a and if it evaluates to 0 print an
  * assertion diagnostic message including the value \em x and abort the
  * program.
+ *
+ * The value is printed without iostreams, and must be a boolean, a character,
+ * a number, an enumeration, a string or a pointer.
  */
-#define ASAP_ASSERT_VAL(a, x)                                  \
-  do {                                                         \
-    if (a) {                                                   \
-    } else {                                                   \
-      std::stringstream __s__;                                 \
-      __s__ << #x ": " << (x);                                 \
-      asap::assert_fail(#a, __LINE__, __FILE__, ASAP_FUNCTION, \
-                        __s__.str().c_str(), 0);               \
-    }                                                          \
-  }                                                            \
+#define ASAP_ASSERT_VAL(a, x)                                               \
+  do {                                                                      \
+    if (HEDLEY_LIKELY(a)) {                                                 \
+    } else                                                                  \
+      asap::details::assert_fail_val(#a, __LINE__, __FILE__, ASAP_FUNCTION, \
+                                     #x, asap::details::assert_value(x));   \
+  }                                                                         \
   ASAP_WHILE_0
 
 /*!
@@ -178,18 +338,45 @@ void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
  * @brief Unconditionally fail, printing an assertion diagnostic message
  * including the value \em x and abort the program.
  */
-#define ASAP_ASSERT_FAIL_VAL(x)                                             \
-  do {                                                                      \
-    std::stringstream __s__;                                                \
-    __s__ << #x ": " << (x);                                                \
-    asap::assert_fail("<unconditional>", __LINE__, __FILE__, ASAP_FUNCTION, \
-                      __s__.str().c_str(), 0);                              \
-  }                                                                         \
-  ASAP_WHILE_0
+#define ASAP_ASSERT_FAIL_VAL(x)                                         \
+  asap::details::assert_fail_val("<unconditional>", __LINE__, __FILE__, \
+                                 ASAP_FUNCTION, #x,                     \
+                                 asap::details::assert_value(x))
+
+/*!
+ * @hideinitializer
+ * @brief Check the precondition \em a like ASAP_ASSERT_PRECOND() when
+ * assertions are enabled, or let the optimizer assume that it holds when they
+ * are off.
+ *
+ * With assertions off, a false expression is undefined behavior: the compiler
+ * may, for example, drop bounds checks or vectorize a loop on the grounds
+ * that \em a is true. Use it for cheap expressions without side effects, which
+ * may or may not be evaluated.
+ */
+#define ASAP_ASSUME(a) ASAP_ASSERT_PRECOND(a)
 
 #endif  // !ASAP_USE_SYSTEM_ASSERTS
 
-#else  // !ASAP_USE_ASSERTS
+#if ASAP_ASSERT_LEVEL >= ASAP_ASSERT_LEVEL_AUDIT || \
+    defined(DOXYGEN_DOCUMENTATION_BUILD)
+/*!
+ * @hideinitializer
+ * @brief Check the expression \em a like ASAP_ASSERT(), but only at the audit
+ * assertion level.
+ *
+ * For checks too expensive to be always on, such as re-validating a whole
+ * data structure or running a slower reference implementation.
+ */
+#define ASAP_ASSERT_AUDIT(a) ASAP_ASSERT(a)
+#else
+#define ASAP_ASSERT_AUDIT(a) \
+  do {                       \
+  }                          \
+  ASAP_WHILE_0
+#endif  // ASAP_ASSERT_LEVEL_AUDIT
+
+#else  // ASAP_ASSERT_LEVEL_OFF
 
 #define ASAP_ASSERT(a) \
   do {                 \
@@ -211,5 +398,10 @@ void ASAP_COMMON_API assert_fail(const char *expr, int line, char const *file,
   do {                          \
   }                             \
   ASAP_WHILE_0
+#define ASAP_ASSERT_AUDIT(a) \
+  do {                       \
+  }                          \
+  ASAP_WHILE_0
+#define ASAP_ASSUME(a) HEDLEY_ASSUME(a)
 
-#endif  // ASAP_USE_ASSERTS
+#endif  // ASAP_ASSERT_LEVEL
@@ -0,0 +1,59 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file crash_handler.h
+ *
+ * @brief Report of fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL) with the
+ * stack of the crashing thread, safe to produce from a signal handler.
+ */
+
+#pragma once
+
+#include <common/asap_common_api.h>
+
+namespace asap {
+
+/*!
+ * @brief Install a handler for SIGSEGV, SIGBUS, SIGFPE and SIGILL that writes
+ * a crash report to the file descriptor \em fd, then lets the signal kill the
+ * process as it would have without the handler (core dump included).
+ *
+ * The report is made of the signal, the faulting address, the return
+ * addresses of the stack of the crashing thread as raw hexadecimal values,
+ * and the executable mappings of /proc/self/maps (where available), so that
+ * the addresses can be symbolized offline, for example with `addr2line -e
+ * <module> <address - mapping start + mapping offset>`. Producing it only
+ * involves async-signal-safe calls: nothing is allocated, locked or
+ * symbolized in the handler. backtrace() is called once here, as its first
+ * call may allocate. set_failure_report_fd() makes the handler also write the
+ * report as a line of JSON.
+ *
+ * The handler runs on an alternate signal stack, so that a stack overflow is
+ * reported too. Signal stacks are per thread: this sets up the one of the
+ * calling thread; other threads call install_crash_stack().
+ *
+ * Can be called again to change the file descriptor. Not supported on
+ * Windows, where it returns false.
+ *
+ * @param fd the file descriptor to write the report to, stderr by default.
+ * @return true if the handler is installed.
+ */
+auto ASAP_COMMON_API install_crash_handler(int fd = 2) -> bool;
+
+/*!
+ * @brief Set up an alternate signal stack for the calling thread, so that the
+ * crash handler can report a stack overflow in that thread.
+ *
+ * The stack is released when the thread exits.
+ *
+ * @return true if the calling thread has an alternate signal stack.
+ */
+auto ASAP_COMMON_API install_crash_stack() -> bool;
+
+/// @brief Restore the signal dispositions found by install_crash_handler().
+void ASAP_COMMON_API uninstall_crash_handler();
+
+}  // namespace asap
@@ -0,0 +1,281 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file enum_flags.h
+ *
+ * @brief Type safe sets of flags of an enumeration, with constexpr bitwise
+ * operators.
+ */
+
+#pragma once
+
+#include <cstddef>  // for std::size_t, std::ptrdiff_t
+#include <iterator>
+#include <type_traits>
+
+/// @cond (INTERNAL_DETAIL)
+// Mutating member functions can only be constexpr from C++14 on.
+#if __cplusplus >= 201402L
+#define ASAP_ENUM_FLAGS_CONSTEXPR14 constexpr
+#else
+#define ASAP_ENUM_FLAGS_CONSTEXPR14
+#endif
+/// @endcond (INTERNAL_DETAIL)
+
+namespace asap {
+
+/// @cond (INTERNAL_DETAIL)
+namespace details {
+
+// Bit counting usable in constant expressions. GCC and clang builtins compile
+// to popcnt and tzcnt/bsf where the target has them; elsewhere, the SWAR
+// versions are still branch free.
+#if defined(__GNUC__) || defined(__clang__)
+constexpr auto popcount(unsigned long long w) -> int {
+  return __builtin_popcountll(w);
+}
+
+// Undefined for 0
+constexpr auto ctz(unsigned long long w) -> int { return __builtin_ctzll(w); }
+#else
+constexpr auto popcount_bytes(unsigned long long w) -> int {
+  return static_cast<int>((w * 0x0101010101010101ULL) >> 56);
+}
+constexpr auto popcount_nibbles(unsigned long long w) -> int {
+  return popcount_bytes((w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL);
+}
+constexpr auto popcount_pairs(unsigned long long w) -> int {
+  return popcount_nibbles((w & 0x3333333333333333ULL) +
+                          ((w >> 2) & 0x3333333333333333ULL));
+}
+constexpr auto popcount(unsigned long long w) -> int {
+  return popcount_pairs(w - ((w >> 1) & 0x5555555555555555ULL));
+}
+
+// Undefined for 0
+constexpr auto ctz(unsigned long long w) -> int {
+  return popcount((w & (0ULL - w)) - 1);
+}
+#endif
+
+}  // namespace details
+/// @endcond (INTERNAL_DETAIL)
+
+/*!
+ * @brief A set of flags of the enumeration \em E, each enumerator being one
+ * bit, or a combination of bits.
+ *
+ * Holds the flags as the unsigned version of the underlying type of \em E:
+ * same size and layout as the enumeration, trivially copyable, and all the
+ * non mutating operations are constexpr. Sets of constant flags fold to a
+ * constant, and a set lives in a register like the integer it wraps, but
+ * only combines with flags of the same enumeration.
+ *
+ * Enumerators convert implicitly to a set, so that they combine with it.
+ * For `flag | flag` to make a set too, declare the operators of the
+ * enumeration with ASAP_ENUM_FLAGS_OPERATORS(), in its namespace.
+ *
+ * @code
+ * enum class Access : unsigned { READ = 1, WRITE = 2, EXECUTE = 4 };
+ * ASAP_ENUM_FLAGS_OPERATORS(Access)
+ *
+ * constexpr asap::EnumFlags<Access> read_write = Access::READ | Access::WRITE;
+ * static_assert(read_write.all(Access::READ), "");
+ *
+ * for (Access flag : read_write) {
+ *   // READ, then WRITE
+ * }
+ * @endcode
+ */
+template <typename E>
+class EnumFlags {
+  static_assert(std::is_enum<E>::value,
+                "EnumFlags only holds flags of an enumeration");
+
+ public:
+  using enum_type = E;
+  using value_type = typename std::make_unsigned<
+      typename std::underlying_type<E>::type>::type;
+
+  /// Iterates over the single bit flags of a set, from the lowest bit.
+  class iterator {
+    using bits_type = typename EnumFlags::value_type;
+
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = E;
+    using difference_type = std::ptrdiff_t;
+    using pointer = E const *;
+    using reference = E;
+
+    constexpr iterator() noexcept : bits_(0) {}
+    constexpr explicit iterator(bits_type bits) noexcept : bits_(bits) {}
+
+    constexpr auto operator*() const noexcept -> E {
+      return static_cast<E>(1ULL << details::ctz(bits_));
+    }
+
+    ASAP_ENUM_FLAGS_CONSTEXPR14 auto operator++() noexcept -> iterator & {
+      // Clear the lowest bit set
+      bits_ = static_cast<bits_type>(bits_ & (bits_ - 1));
+      return *this;
+    }
+
+    ASAP_ENUM_FLAGS_CONSTEXPR14 auto operator++(int) noexcept -> iterator {
+      iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    constexpr auto operator==(iterator other) const noexcept -> bool {
+      return bits_ == other.bits_;
+    }
+    constexpr auto operator!=(iterator other) const noexcept -> bool {
+      return bits_ != other.bits_;
+    }
+
+   private:
+    bits_type bits_;
+  };
+
+  /// An empty set.
+  constexpr EnumFlags() noexcept : EnumFlags(0, 0) {}
+
+  /// The set of the bits of \em flag.
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr EnumFlags(E flag) noexcept
+      : EnumFlags(static_cast<value_type>(flag), 0) {}
+
+  /// The set with the bits of \em bits, which may not be enumerators of E.
+  static constexpr auto from_value(value_type bits) noexcept -> EnumFlags {
+    return EnumFlags(bits, 0);
+  }
+
+  /// The bits of the set.
+  constexpr auto value() const noexcept -> value_type { return bits_; }
+
+  /// Is some bit set?
+  constexpr auto any() const noexcept -> bool { return bits_ != 0; }
+  /// Is no bit set?
+  constexpr auto none() const noexcept -> bool { return bits_ == 0; }
+
+  /// Is some bit of \em flags set?
+  constexpr auto any(EnumFlags flags) const noexcept -> bool {
+    return (bits_ & flags.bits_) != 0;
+  }
+  /// Are all the bits of \em flags set? Same as FlagTest().
+  constexpr auto all(EnumFlags flags) const noexcept -> bool {
+    return (bits_ & flags.bits_) == flags.bits_;
+  }
+  /// Is no bit of \em flags set?
+  constexpr auto none(EnumFlags flags) const noexcept -> bool {
+    return (bits_ & flags.bits_) == 0;
+  }
+
+  /// Number of bits set.
+  constexpr auto count() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(details::popcount(bits_));
+  }
+
+  constexpr explicit operator bool() const noexcept { return bits_ != 0; }
+
+  constexpr auto begin() const noexcept -> iterator { return iterator(bits_); }
+  constexpr auto end() const noexcept -> iterator { return iterator(0); }
+
+  /// Set the bits of \em flags, as FlagSet().
+  ASAP_ENUM_FLAGS_CONSTEXPR14 auto set(EnumFlags flags) noexcept
+      -> EnumFlags & {
+    return *this |= flags;
+  }
+  /// Clear the bits of \em flags, as FlagClear().
+  ASAP_ENUM_FLAGS_CONSTEXPR14 auto clear(EnumFlags flags) noexcept
+      -> EnumFlags & {
+    return *this &= ~flags;
+  }
+  /// Flip the bits of \em flags, as FlagFlip().
+  ASAP_ENUM_FLAGS_CONSTEXPR14 auto flip(EnumFlags flags) noexcept
+      -> EnumFlags & {
+    return *this ^= flags;
+  }
+
+  ASAP_ENUM_FLAGS_CONSTEXPR14 auto operator|=(EnumFlags flags) noexcept
+      -> EnumFlags & {
+    bits_ = static_cast<value_type>(bits_ | flags.bits_);
+    return *this;
+  }
+  ASAP_ENUM_FLAGS_CONSTEXPR14 auto operator&=(EnumFlags flags) noexcept
+      -> EnumFlags & {
+    bits_ = static_cast<value_type>(bits_ & flags.bits_);
+    return *this;
+  }
+  ASAP_ENUM_FLAGS_CONSTEXPR14 auto operator^=(EnumFlags flags) noexcept
+      -> EnumFlags & {
+    bits_ = static_cast<value_type>(bits_ ^ flags.bits_);
+    return *this;
+  }
+
+  friend constexpr auto operator|(EnumFlags a, EnumFlags b) noexcept
+      -> EnumFlags {
+    return EnumFlags(static_cast<value_type>(a.bits_ | b.bits_), 0);
+  }
+  friend constexpr auto operator&(EnumFlags a, EnumFlags b) noexcept
+      -> EnumFlags {
+    return EnumFlags(static_cast<value_type>(a.bits_ & b.bits_), 0);
+  }
+  friend constexpr auto operator^(EnumFlags a, EnumFlags b) noexcept
+      -> EnumFlags {
+    return EnumFlags(static_cast<value_type>(a.bits_ ^ b.bits_), 0);
+  }
+  /// All the bits of the underlying type but the ones of \em a.
+  friend constexpr auto operator~(EnumFlags a) noexcept -> EnumFlags {
+    return EnumFlags(static_cast<value_type>(~a.bits_), 0);
+  }
+
+  friend constexpr auto operator==(EnumFlags a, EnumFlags b) noexcept
+      -> bool {
+    return a.bits_ == b.bits_;
+  }
+  friend constexpr auto operator!=(EnumFlags a, EnumFlags b) noexcept
+      -> bool {
+    return a.bits_ != b.bits_;
+  }
+
+ private:
+  // All the constructors end up here, where the class is complete
+  constexpr EnumFlags(value_type bits, int /*tag*/) noexcept : bits_(bits) {
+    static_assert(sizeof(EnumFlags) == sizeof(E) &&
+                      alignof(EnumFlags) == alignof(E),
+                  "EnumFlags must have the size and alignment of its enum");
+    static_assert(std::is_standard_layout<EnumFlags>::value &&
+                      std::is_trivially_copyable<EnumFlags>::value,
+                  "EnumFlags must have the layout of an integer");
+  }
+
+  value_type bits_;
+};
+
+}  // namespace asap
+
+/*!
+ * @brief Declare the bitwise operators of the enumeration \em E, so that
+ * combining its enumerators makes an asap::EnumFlags<E>.
+ *
+ * To be used in the namespace of \em E, where argument dependent lookup finds
+ * the operators.
+ */
+#define ASAP_ENUM_FLAGS_OPERATORS(E)                                     \
+  constexpr auto operator|(E a, E b) noexcept -> ::asap::EnumFlags<E> { \
+    return ::asap::EnumFlags<E>(a) | b;                                 \
+  }                                                                     \
+  constexpr auto operator&(E a, E b) noexcept -> ::asap::EnumFlags<E> { \
+    return ::asap::EnumFlags<E>(a) & b;                                 \
+  }                                                                     \
+  constexpr auto operator^(E a, E b) noexcept -> ::asap::EnumFlags<E> { \
+    return ::asap::EnumFlags<E>(a) ^ b;                                 \
+  }                                                                     \
+  constexpr auto operator~(E a) noexcept -> ::asap::EnumFlags<E> {      \
+    return ~::asap::EnumFlags<E>(a);                                    \
+  }
@@ -0,0 +1,60 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file failure_report.h
+ *
+ * @brief Machine readable reports of failed assertions and crashes, for tools
+ * that collect and symbolize them.
+ */
+
+#pragma once
+
+#include <common/asap_common_api.h>
+
+namespace asap {
+
+/*!
+ * @brief Also report each failed assertion, and each fatal signal caught by
+ * the crash handler, as one line of JSON written to the file descriptor
+ * \em fd.
+ *
+ * The text reports are still written as usual. A record is an object with
+ * these members, null when they do not apply:
+ *   - `kind`: `"assertion"`, `"precondition"` or `"crash"`;
+ *   - `expression`, `file`, `line`, `function`, `value`: the failed
+ *     assertion, and the value it printed;
+ *   - `signal`, `address`: the fatal signal number and the faulting address;
+ *   - `pid`, `thread`: the process and the failing thread (its kernel thread
+ *     id on Linux);
+ *   - `timestamp_ns`: nanoseconds since the epoch (CLOCK_REALTIME);
+ *   - `frames`: the return addresses of the stack of the failing thread, the
+ *     innermost first, as hexadecimal strings;
+ *   - `modules`: the executable mappings of the process as `start`, `end`,
+ *     `offset` and `path` (from /proc/self/maps where available), to
+ *     symbolize the frames offline.
+ *
+ * Addresses are strings such as `"0x7f0c1a2b3c4d"`. Strings are copied as is
+ * but for the characters JSON requires to escape, and for the bytes that are
+ * not part of a well-formed UTF-8 sequence, each replaced by `\ufffd`: file
+ * names, expressions, values and module paths that are not valid UTF-8 are
+ * changed that way, so that the records are always valid JSON.
+ *
+ * A record is formatted into a fixed buffer on the stack and written with
+ * write(), without allocating, locking nor symbolizing: reporting works when
+ * the heap is exhausted or corrupted, and from the crash handler. Records up
+ * to 4 KiB go out in a single write(). Only supported on POSIX systems;
+ * nothing is written elsewhere.
+ *
+ * @param fd the file descriptor to write the records to, or a negative value
+ * to stop writing them, which is the default.
+ */
+void ASAP_COMMON_API set_failure_report_fd(int fd);
+
+/// @brief The file descriptor set by set_failure_report_fd(), negative if
+/// none.
+auto ASAP_COMMON_API failure_report_fd() -> int;
+
+}  // namespace asap
@@ -7,6 +7,9 @@
 
 #include <common/traits/logical.h>
 
+#include <atomic>
+#include <type_traits>
+
 namespace asap {
 
 /*!
@@ -68,4 +71,173 @@ bool FlagTest(T mask, T flags) {
   return (mask & flags) == flags;
 }
 
+/// @cond (INTERNAL_DETAIL)
+namespace details {
+
+// Keeps the type of the flags of the atomic overloads from being deduced, so
+// that they can be given as literals.
+template <typename T>
+struct flag_type {
+  using type = T;
+};
+
+template <typename T>
+using enable_if_atomic_flags =
+    typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_same<T, bool>::value>::type;
+
+// The strongest order a load can have when \p order is the order of a
+// read-modify-write operation: the one of a failed compare exchange.
+inline auto flag_load_order(std::memory_order order) -> std::memory_order {
+  return order == std::memory_order_acq_rel   ? std::memory_order_acquire
+         : order == std::memory_order_release ? std::memory_order_relaxed
+                                              : order;
+}
+
+}  // namespace details
+/// @endcond (INTERNAL_DETAIL)
+
+/*!
+ * @brief Atomically set bits in a mask based on the bits set in flags.
+ *
+ * A single `fetch_or`, i.e. a `lock or` on x86 when the result is not used.
+ *
+ * @param[in,out] mask   the bitset mask to be changed.
+ * @param[in]     flags  the flags to set in the mask. May contain one or more
+ * bits to set.
+ * @param[in]     order  the memory order of the operation.
+ *
+ * @return the value of the mask before the change.
+ */
+template <typename T, typename = details::enable_if_atomic_flags<T>>
+auto FlagSet(std::atomic<T> &mask, typename details::flag_type<T>::type flags,
+             std::memory_order order = std::memory_order_seq_cst) -> T {
+  return mask.fetch_or(flags, order);
+}
+
+/*!
+ * @brief Atomically clear bits in a mask based on the bits set in flags.
+ *
+ * A single `fetch_and` with the complement of \p flags.
+ *
+ * @param[in,out] mask   the bitset mask to be changed.
+ * @param[in]     flags  the flags to clear in the mask. May contain one or more
+ * bits to clear.
+ * @param[in]     order  the memory order of the operation.
+ *
+ * @return the value of the mask before the change.
+ */
+template <typename T, typename = details::enable_if_atomic_flags<T>>
+auto FlagClear(std::atomic<T> &mask,
+               typename details::flag_type<T>::type flags,
+               std::memory_order order = std::memory_order_seq_cst) -> T {
+  return mask.fetch_and(static_cast<T>(~flags), order);
+}
+
+/*!
+ * @brief Atomically flip bits ('0' to '1' and '1' to '0') in a mask based on
+ * the bits set in flags.
+ *
+ * A single `fetch_xor`.
+ *
+ * @param[in,out] mask   the bitset mask to be changed.
+ * @param[in]     flags  the flags to flip in the mask. May contain one or more
+ * bits to flip.
+ * @param[in]     order  the memory order of the operation.
+ *
+ * @return the value of the mask before the change.
+ */
+template <typename T, typename = details::enable_if_atomic_flags<T>>
+auto FlagFlip(std::atomic<T> &mask, typename details::flag_type<T>::type flags,
+              std::memory_order order = std::memory_order_seq_cst) -> T {
+  return mask.fetch_xor(flags, order);
+}
+
+/*!
+ * @brief Check if the bits set in `flags` are also set in an atomic `mask`.
+ *
+ * @param[in] mask   the bitset mask to be tested.
+ * @param[in] flags  the flags to check in the mask. May contain one or more
+ * bits to set.
+ * @param[in] order  the memory order of the load of the mask; must be valid
+ * for a load.
+ *
+ * @return \b true if the flags are set in mask; otherwise \b false;
+ */
+template <typename T, typename = details::enable_if_atomic_flags<T>>
+auto FlagTest(std::atomic<T> const &mask,
+              typename details::flag_type<T>::type flags,
+              std::memory_order order = std::memory_order_seq_cst) -> bool {
+  return (mask.load(order) & flags) == flags;
+}
+
+/*!
+ * @brief Atomically change a mask from one state to another: set and clear
+ * bits, only if some bits are set and others are clear.
+ *
+ * A single compare exchange loop, which only retries when another thread
+ * changed the mask in the meantime. The condition is checked on each value
+ * seen, so the transition never applies to a mask that does not satisfy it.
+ *
+ * @code
+ * // Take ownership of a connection, unless it is closing
+ * if (FlagTransition(state, 0, CLOSING | OWNED, OWNED, 0,
+ *                    std::memory_order_acquire)) {
+ *   ...
+ * }
+ * @endcode
+ *
+ * @param[in,out] mask          the bitset mask to be changed.
+ * @param[in]     require_set   the flags that must all be set in the mask.
+ * @param[in]     require_clear the flags that must all be clear in the mask.
+ * @param[in]     set           the flags to set.
+ * @param[in]     clear         the flags to clear, before setting \p set.
+ * @param[in]     order         the memory order of the change; a failed
+ * check has the corresponding load order.
+ *
+ * @return \b true if the mask satisfied the condition and was changed;
+ * otherwise \b false.
+ */
+template <typename T, typename = details::enable_if_atomic_flags<T>>
+auto FlagTransition(std::atomic<T> &mask,
+                    typename details::flag_type<T>::type require_set,
+                    typename details::flag_type<T>::type require_clear,
+                    typename details::flag_type<T>::type set,
+                    typename details::flag_type<T>::type clear,
+                    std::memory_order order = std::memory_order_seq_cst)
+    -> bool {
+  T current = mask.load(details::flag_load_order(order));
+  do {
+    if ((current & require_set) != require_set ||
+        (current & require_clear) != 0) {
+      return false;
+    }
+  } while (!mask.compare_exchange_weak(
+      current, static_cast<T>((current & ~clear) | set), order,
+      details::flag_load_order(order)));
+  return true;
+}
+
+/*!
+ * @brief Atomically set bits in a mask, only if other bits are all clear.
+ *
+ * @param[in,out] mask   the bitset mask to be changed.
+ * @param[in]     flags  the flags to set in the mask.
+ * @param[in]     guard  the flags that must be clear in the mask for the
+ * flags to be set.
+ * @param[in]     order  the memory order of the change.
+ *
+ * @return \b true if the flags were set; otherwise \b false.
+ *
+ * @see FlagTransition
+ */
+template <typename T, typename = details::enable_if_atomic_flags<T>>
+auto FlagSetIfClear(std::atomic<T> &mask,
+                    typename details::flag_type<T>::type flags,
+                    typename details::flag_type<T>::type guard,
+                    std::memory_order order = std::memory_order_seq_cst)
+    -> bool {
+  return FlagTransition(mask, T(0), guard, flags, T(0), order);
+}
+
 }  // namespace asap
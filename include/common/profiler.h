@@ -0,0 +1,91 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file profiler.h
+ *
+ * @brief In-process sampling CPU profiler, for when no external profiler can
+ * be attached.
+ */
+
+#pragma once
+
+#include <common/asap_common_api.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types
+#include <string>
+
+namespace asap {
+
+/// @brief Counters of the profiler since it was last started.
+struct profiler_statistics {
+  /// Samples recorded in the buffers of the threads
+  std::uint64_t samples;
+  /// Samples lost because the buffer of their thread was full
+  std::uint64_t dropped;
+  /// Samples lost because they hit a thread that was not registered
+  std::uint64_t unregistered;
+  /// Buffers allocated since the process started
+  std::uint64_t buffers;
+};
+
+/*!
+ * @brief Start sampling the call stacks of the threads of the process.
+ *
+ * A SIGPROF signal is delivered \em frequency_hz times per second of CPU time
+ * consumed by the process (setitimer(ITIMER_PROF)), to the thread that is
+ * running. Its handler captures the stack of that thread with
+ * stack_trace::capture() into a ring buffer of \em samples_per_thread entries
+ * owned by the thread: recording a sample does not allocate, lock, nor
+ * symbolize. At 100 Hz, the overhead is a few microseconds every 10 ms of
+ * CPU, well under 1%.
+ *
+ * Samples only go to threads registered with profiler_register_thread(),
+ * which the calling thread is. Buffers are drained by
+ * profiler_folded_stacks(), which must be called often enough for them not
+ * to fill up.
+ *
+ * Only supported on POSIX systems with execinfo.h; returns false elsewhere,
+ * or if the profiler is already running. The SIGPROF handler and the
+ * ITIMER_PROF timer of the process are taken over until stop_profiler().
+ *
+ * @param frequency_hz samples per second of CPU time.
+ * @param samples_per_thread capacity of the buffer of each thread registered
+ * from now on.
+ */
+auto ASAP_COMMON_API start_profiler(int frequency_hz = 100,
+                                    std::size_t samples_per_thread = 1024)
+    -> bool;
+
+/// @brief Stop sampling, and restore the previous SIGPROF handler. The
+/// samples not dumped yet are kept.
+void ASAP_COMMON_API stop_profiler();
+
+/*!
+ * @brief Let the calling thread be sampled by the profiler, allocating its
+ * buffer if it has none yet.
+ *
+ * The buffer outlives the thread, so that its samples can still be dumped
+ * after it exits. Once they are, the buffer is reused by the next thread
+ * registered.
+ */
+void ASAP_COMMON_API profiler_register_thread();
+
+/*!
+ * @brief Drain the samples of all the threads into folded stacks.
+ *
+ * Each line is a distinct stack, from the outermost function to the innermost
+ * one separated by semicolons, followed by a space and the number of samples
+ * that hit it: the input format of flamegraph.pl and compatible tools.
+ * Functions without a known symbol appear as their address. Can be called
+ * while the profiler runs.
+ */
+auto ASAP_COMMON_API profiler_folded_stacks() -> std::string;
+
+/// @brief The counters of the profiler since it was last started.
+auto ASAP_COMMON_API profiler_stats() -> profiler_statistics;
+
+}  // namespace asap
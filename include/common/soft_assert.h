@@ -0,0 +1,158 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file soft_assert.h
+ *
+ * @brief Assertions that report a violated invariant and let the program go
+ * on, for production builds.
+ */
+
+#pragma once
+
+#include <common/asap_common_api.h>
+#include <common/assert.h>
+
+#include <atomic>
+#include <cstdint>  // for int types
+#include <vector>
+
+namespace asap {
+
+/*!
+ * @brief An assertion site of ASAP_ASSERT_SOFT(), with its counters.
+ *
+ * There is one static instance per use of the macro, constant initialized:
+ * it costs nothing until the assertion fails for the first time, when it is
+ * added, without locking, to the list of sites returned by
+ * soft_assert_snapshot().
+ */
+struct soft_assert_site {
+  constexpr soft_assert_site(char const *site_expr, char const *site_file,
+                             int site_line, char const *site_function)
+      : expr(site_expr),
+        file(site_file),
+        line(site_line),
+        function(site_function) {}
+
+  soft_assert_site(soft_assert_site const &) = delete;
+  auto operator=(soft_assert_site const &) -> soft_assert_site & = delete;
+
+  char const *const expr;
+  char const *const file;
+  int const line;
+  char const *const function;
+
+  /// Number of times the assertion failed
+  std::atomic<std::uint64_t> hits{0};
+  /// Number of failures passed on to the handler
+  std::atomic<std::uint64_t> reports{0};
+  /// Time of the last report, in steady clock nanoseconds
+  std::atomic<std::int64_t> last_report{0};
+  /// Next site in the list of the sites that failed
+  soft_assert_site *next{nullptr};
+};
+
+/// @brief A failure of a soft assertion, as passed to the handler.
+struct soft_assert_report {
+  /// The assertion site
+  soft_assert_site const &site;
+  /// Number of failures of the site so far, this one included
+  std::uint64_t hits;
+  /// Number of failures of the site dropped by the rate limit so far
+  std::uint64_t suppressed;
+};
+
+/// @brief Function called with the soft assertion failures to report.
+using soft_assert_handler = void (*)(soft_assert_report const &report);
+
+/*!
+ * @brief Set the function called with the failures to report, and return the
+ * previous one.
+ *
+ * The handler may be called concurrently from several threads, and must not
+ * itself fail a soft assertion. A null handler restores the default one,
+ * which prints the failure to stderr.
+ */
+auto ASAP_COMMON_API set_soft_assert_handler(soft_assert_handler handler)
+    -> soft_assert_handler;
+
+/*!
+ * @brief Set how many failures of each site are reported.
+ *
+ * The first \em first_reports failures of a site are all reported; after
+ * that, a failure is only reported if the previous report of the site is at
+ * least \em interval_ms milliseconds old, with the number of failures
+ * suppressed in between. The default is 10 reports, then one per second.
+ */
+void ASAP_COMMON_API set_soft_assert_rate_limit(std::uint64_t first_reports,
+                                                std::int64_t interval_ms);
+
+/// @brief Counters of a soft assertion site, as returned by
+/// soft_assert_snapshot().
+struct soft_assert_stats {
+  char const *expr;
+  char const *file;
+  int line;
+  char const *function;
+  std::uint64_t hits;
+  std::uint64_t reports;
+};
+
+/*!
+ * @brief The counters of all the soft assertion sites that failed at least
+ * once, e.g. to export them as metrics.
+ *
+ * Sites are listed from the most recent first failure to the oldest. The
+ * counters are read one after the other, while other threads may still
+ * update them.
+ */
+auto ASAP_COMMON_API soft_assert_snapshot() -> std::vector<soft_assert_stats>;
+
+/*!
+ * @brief Count the failure of a soft assertion site and report it if the rate
+ * limit allows it.
+ *
+ * This function is used internally by ASAP_ASSERT_SOFT(). It is not intended
+ * to be used as-is.
+ */
+ASAP_COLD void ASAP_COMMON_API soft_assert_fail(soft_assert_site &site);
+
+}  // namespace asap
+
+#if ASAP_SOFT_ASSERTS || defined(DOXYGEN_DOCUMENTATION_BUILD)
+
+/*!
+ * @hideinitializer
+ * @brief Check the expression \em a and if it evaluates to 0 count and
+ * report the failure, then go on.
+ *
+ * Meant for invariants whose violation should be known, but must not take
+ * a production program down: unlike the other assertion macros, it does not
+ * depend on the assertion level, and is only compiled out when the
+ * ASAP_SOFT_ASSERTS CMake option is turned off. A failure that is not
+ * reported costs an atomic increment and a clock read. See
+ * set_soft_assert_handler(), set_soft_assert_rate_limit() and
+ * soft_assert_snapshot().
+ */
+#define ASAP_ASSERT_SOFT(a)                                                \
+  do {                                                                     \
+    if (HEDLEY_LIKELY(a)) {                                                \
+    } else {                                                               \
+      static asap::soft_assert_site asap_soft_assert_site_(                \
+          #a, __FILE__, __LINE__, ASAP_FUNCTION);                          \
+      asap::soft_assert_fail(asap_soft_assert_site_);                      \
+    }                                                                      \
+  }                                                                        \
+  ASAP_WHILE_0
+
+#else  // ASAP_SOFT_ASSERTS
+
+#define ASAP_ASSERT_SOFT(a) \
+  do {                      \
+  }                         \
+  ASAP_WHILE_0
+
+#endif  // ASAP_SOFT_ASSERTS
@@ -0,0 +1,107 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file stack_trace.h
+ *
+ * @brief Cheap capture of the call stack, symbolized on demand.
+ */
+
+#pragma once
+
+#include <common/asap_common_api.h>
+
+#include <array>
+#include <cstddef>  // for std::size_t
+#include <string>
+
+namespace asap {
+
+/*!
+ * @brief The return addresses of the call stack of a thread, captured at some
+ * point.
+ *
+ * Capturing only walks the stack and copies the addresses into the object:
+ * nothing is allocated nor symbolized, which makes it cheap enough to record
+ * the call sites of allocations or of slow requests. Traces are values that
+ * can be copied, compared and hashed, e.g. to count the occurrences of each
+ * distinct trace.
+ *
+ * Symbol names are looked up when asked for, with symbol() or to_string().
+ * The demangled names are kept in a process wide cache keyed by address, so
+ * printing traces that go through the same code again costs a lookup per
+ * frame.
+ *
+ * @code
+ * auto trace = asap::stack_trace::capture();
+ * ...
+ * std::fputs(trace.to_string().c_str(), stderr);
+ * @endcode
+ */
+class ASAP_COMMON_API stack_trace {
+ public:
+  /// Maximum number of frames kept; the outermost ones are dropped.
+  static constexpr std::size_t max_frames = 32;
+
+  using const_iterator = void *const *;
+
+  /// An empty trace.
+  stack_trace() = default;
+
+  /*!
+   * @brief Capture the stack of the calling thread.
+   *
+   * @param skip number of frames to drop, from the innermost one: 0 makes the
+   * caller of capture() the first frame.
+   */
+  static auto capture(std::size_t skip = 0) -> stack_trace;
+
+  /// Number of frames.
+  auto size() const -> std::size_t { return size_; }
+  auto empty() const -> bool { return size_ == 0; }
+
+  /// Return address of the frame \em index, 0 being the innermost one.
+  auto operator[](std::size_t index) const -> void * { return frames_[index]; }
+
+  auto begin() const -> const_iterator { return frames_.data(); }
+  auto end() const -> const_iterator { return frames_.data() + size_; }
+
+  /*!
+   * @brief The demangled name of the function of the frame \em index, or an
+   * empty string if it is not known.
+   *
+   * Only exported symbols can be named from the dynamic symbol tables; link
+   * with `-rdynamic` to name the functions of the executable too.
+   */
+  auto symbol(std::size_t index) const -> std::string;
+
+  /// One line per frame: index, address, and name + offset if known.
+  auto to_string() const -> std::string;
+
+  /// A hash of the return addresses.
+  auto hash() const -> std::size_t;
+
+  friend auto operator==(stack_trace const &a, stack_trace const &b) -> bool {
+    if (a.size_ != b.size_) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.size_; ++i) {
+      if (a.frames_[i] != b.frames_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend auto operator!=(stack_trace const &a, stack_trace const &b) -> bool {
+    return !(a == b);
+  }
+
+ private:
+  std::array<void *, max_frames> frames_{};
+  std::size_t size_{0};
+};
+
+}  // namespace asap
@@ -0,0 +1,266 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file byte_order.h
+ *
+ * @brief Decoding of UTF-16 and UTF-32 code units straight from raw byte
+ * buffers in either byte order.
+ */
+
+#pragma once
+
+#include <common/unicode/detect.h>
+#include <common/unicode/encoding_errors.h>
+#include <common/unicode/encoding_utf.h>
+#include <common/unicode/swar.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types
+#include <cstring>  // for std::memcpy
+#include <iterator>
+#include <string>
+
+namespace nowide {
+namespace utf {
+
+/// The order of the bytes within a multi-byte code unit.
+enum class byte_order {
+  little,  ///< Least significant byte first
+  big,     ///< Most significant byte first
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && \
+    (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  native = big  ///< The byte order of the host
+#else
+  native = little  ///< The byte order of the host
+#endif
+};
+
+/// \cond INTERNAL
+namespace details {
+
+inline auto byte_swap(std::uint16_t v) -> std::uint16_t {
+  return static_cast<std::uint16_t>((v >> 8) | (v << 8));
+}
+
+inline auto byte_swap(std::uint32_t v) -> std::uint32_t {
+  return (v >> 24) | ((v >> 8) & 0xFF00U) | ((v << 8) & 0xFF0000U) | (v << 24);
+}
+
+/// Unsigned integer type of a code unit.
+template <std::size_t size>
+struct unit_type;
+template <>
+struct unit_type<2> {
+  using type = std::uint16_t;
+};
+template <>
+struct unit_type<4> {
+  using type = std::uint32_t;
+};
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Load one code unit of type \a UnitType stored in byte order \a Order
+/// at address \a p.
+///
+template <typename UnitType, byte_order Order>
+inline auto load_unit(void const *p) -> UnitType {
+  using raw_type = typename details::unit_type<sizeof(UnitType)>::type;
+  raw_type raw;
+  std::memcpy(&raw, p, sizeof(raw));
+  if (Order != byte_order::native) {
+    raw = details::byte_swap(raw);
+  }
+  return static_cast<UnitType>(raw);
+}
+
+///
+/// \brief Input iterator presenting a raw byte buffer as a sequence of UTF-16
+/// or UTF-32 code units stored in byte order \a Order.
+///
+/// It lets the utf_traits decoders work directly on wire data:
+///
+/// \code
+/// using it = nowide::utf::byte_order_iterator<char16_t, byte_order::big>;
+/// it first(data), last(data + size);
+/// code_point c = utf_traits<char16_t>::decode(first, last);
+/// \endcode
+///
+/// The distance between the two ends of a range must be a multiple of the
+/// code unit size.
+///
+template <typename UnitType, byte_order Order>
+class byte_order_iterator {
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = UnitType;
+  using difference_type = std::ptrdiff_t;
+  using pointer = UnitType const *;
+  using reference = UnitType;
+
+  byte_order_iterator() = default;
+
+  /// Iterate over the bytes starting at \a p.
+  explicit byte_order_iterator(void const *p)
+      : p_(static_cast<unsigned char const *>(p)) {}
+
+  auto operator*() const -> UnitType { return load_unit<UnitType, Order>(p_); }
+
+  auto operator++() -> byte_order_iterator & {
+    p_ += sizeof(UnitType);
+    return *this;
+  }
+
+  auto operator++(int) -> byte_order_iterator {
+    byte_order_iterator tmp(*this);
+    p_ += sizeof(UnitType);
+    return tmp;
+  }
+
+  auto operator==(byte_order_iterator const &other) const -> bool {
+    return p_ == other.p_;
+  }
+
+  auto operator!=(byte_order_iterator const &other) const -> bool {
+    return p_ != other.p_;
+  }
+
+  /// The address of the next byte to be read.
+  auto base() const -> unsigned char const * { return p_; }
+
+ private:
+  unsigned char const *p_{nullptr};
+};
+
+}  // namespace utf
+
+namespace conv {
+
+/// \cond INTERNAL
+namespace details {
+
+///
+/// Transcode \a units code units of type \a UnitType read from the bytes at
+/// \a p, swapping their bytes if \a swap is set, and append the result to
+/// \a result.
+///
+/// The input is handled in blocks: each block is loaded (and byte swapped) in
+/// a tight loop the compiler can vectorize into a small buffer that stays in
+/// the L1 cache, and is then transcoded from there. A surrogate pair split
+/// over two blocks is carried over to the next one.
+///
+template <typename UnitType, typename String>
+void append_swapped(unsigned char const *p, std::size_t units, bool swap,
+                    String &result) {
+  using char_out = typename String::value_type;
+  using raw_type = typename utf::details::unit_type<sizeof(UnitType)>::type;
+  static const std::size_t block_size = 256;
+
+  raw_type block[block_size];
+  std::size_t carry = 0;
+  std::back_insert_iterator<String> inserter(result);
+  while (units != 0) {
+    std::size_t count = block_size - carry;
+    if (count > units) {
+      count = units;
+    }
+    std::memcpy(block + carry, p, count * sizeof(raw_type));
+    if (swap) {
+      for (std::size_t i = carry; i < carry + count; ++i) {
+        block[i] = utf::details::byte_swap(block[i]);
+      }
+    }
+    p += count * sizeof(raw_type);
+    units -= count;
+
+    raw_type const *first = block;
+    raw_type const *last = block + carry + count;
+    carry = 0;
+    while (first != last) {
+      raw_type const *ascii_end = utf::details::ascii_prefix(first, last);
+      result.append(first, ascii_end);
+      first = ascii_end;
+      if (first == last) {
+        break;
+      }
+      raw_type const *start = first;
+      utf::code_point c =
+          utf::utf_traits<UnitType>::template decode<raw_type const *>(first,
+                                                                       last);
+      if (c == utf::incomplete && units != 0) {
+        carry = static_cast<std::size_t>(last - start);
+        std::memmove(block, start, carry * sizeof(raw_type));
+        break;
+      }
+      if (c == utf::illegal || c == utf::incomplete) {
+        throw conversion_error();
+      }
+      utf::utf_traits<char_out>::encode(c, inserter);
+    }
+  }
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Convert the raw bytes [data, data + size) encoded in \a source to
+/// the Unicode encoding of \a CharOut, in a single pass.
+///
+/// UTF-16 and UTF-32 input can be in either byte order; code units that are
+/// not in the host order are byte swapped on the fly. The data is expected to
+/// start after the byte order mark, if any (see utf::detected_encoding).
+///
+/// nowide::conv::conversion_error is thrown if the data is not well formed, is
+/// not a whole number of code units, or if \a source is utf::encoding::unknown.
+///
+template <typename CharOut, typename Traits = std::char_traits<CharOut>,
+          class Allocator = std::allocator<CharOut>>
+auto bytes_to_utf(void const *data, std::size_t size, utf::encoding source,
+                  const Allocator &alloc = Allocator())
+    -> std::basic_string<CharOut, Traits, Allocator> {
+  using string_type = std::basic_string<CharOut, Traits, Allocator>;
+  auto p = static_cast<unsigned char const *>(data);
+  const bool big = utf::byte_order::native == utf::byte_order::big;
+  switch (source) {
+    case utf::encoding::utf8: {
+      auto text = reinterpret_cast<char const *>(p);
+      return utf_to_utf<CharOut, char, Traits, Allocator>(text, text + size,
+                                                          alloc);
+    }
+    case utf::encoding::utf16le:
+    case utf::encoding::utf16be: {
+      if (size % 2 != 0) {
+        throw conversion_error();
+      }
+      string_type result(alloc);
+      result.reserve(size / 2);
+      details::append_swapped<char16_t>(
+          p, size / 2, big != (source == utf::encoding::utf16be), result);
+      return result;
+    }
+    case utf::encoding::utf32le:
+    case utf::encoding::utf32be: {
+      if (size % 4 != 0) {
+        throw conversion_error();
+      }
+      string_type result(alloc);
+      result.reserve(size / 4);
+      details::append_swapped<char32_t>(
+          p, size / 4, big != (source == utf::encoding::utf32be), result);
+      return result;
+    }
+    case utf::encoding::unknown:
+      break;
+  }
+  throw conversion_error();
+}
+
+}  // namespace conv
+}  // namespace nowide
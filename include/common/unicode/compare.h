@@ -0,0 +1,188 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file compare.h
+ *
+ * @brief Comparison of Unicode text in any two UTF encodings, in code point
+ * order, without converting either side.
+ */
+
+#pragma once
+
+#include <common/unicode/swar.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for std::uint32_t
+#include <string>
+#include <type_traits>
+
+namespace nowide {
+namespace utf {
+
+/// \cond INTERNAL
+namespace details {
+
+///
+/// Skip the longest common prefix of ASCII code units of two ranges with the
+/// same code unit width, a word at a time. Both ranges are advanced.
+///
+template <typename CharA, typename CharB>
+void skip_common_ascii(CharA const *&a, CharA const *a_end, CharB const *&b,
+                       CharB const *b_end) {
+  static_assert(sizeof(CharA) == sizeof(CharB), "same code unit width only");
+  static const std::size_t units = word_size / sizeof(CharA);
+  const word_type mask = non_ascii_mask<sizeof(CharA)>::value;
+  while (static_cast<std::size_t>(a_end - a) >= units &&
+         static_cast<std::size_t>(b_end - b) >= units) {
+    word_type wa = load_word(a);
+    if (wa != load_word(b) || (wa & mask) != 0) {
+      break;
+    }
+    a += units;
+    b += units;
+  }
+}
+
+template <typename CharA, typename CharB>
+void skip_common_ascii_if_same_width(CharA const *&a, CharA const *a_end,
+                                     CharB const *&b, CharB const *b_end,
+                                     std::true_type /*same_width*/) {
+  skip_common_ascii(a, a_end, b, b_end);
+}
+
+template <typename CharA, typename CharB>
+void skip_common_ascii_if_same_width(CharA const *& /*a*/,
+                                     CharA const * /*a_end*/,
+                                     CharB const *& /*b*/,
+                                     CharB const * /*b_end*/,
+                                     std::false_type /*same_width*/) {}
+
+///
+/// Order of two ill-formed sequences: by their code unit values, as unsigned
+/// numbers, then by length.
+///
+template <typename CharA, typename CharB>
+auto compare_units(CharA const *a, CharA const *a_end, CharB const *b,
+                   CharB const *b_end) -> int {
+  using unsigned_a = typename std::make_unsigned<CharA>::type;
+  using unsigned_b = typename std::make_unsigned<CharB>::type;
+  for (; a != a_end && b != b_end; ++a, ++b) {
+    auto ua = static_cast<std::uint32_t>(static_cast<unsigned_a>(*a));
+    auto ub = static_cast<std::uint32_t>(static_cast<unsigned_b>(*b));
+    if (ua != ub) {
+      return ua < ub ? -1 : 1;
+    }
+  }
+  if (a != a_end) {
+    return 1;
+  }
+  return b != b_end ? -1 : 0;
+}
+
+///
+/// Decode the next code point of each range and compare them. Code points
+/// sort before ill-formed sequences, which sort by their code units.
+///
+template <typename CharA, typename CharB>
+auto compare_next(CharA const *&a, CharA const *a_end, CharB const *&b,
+                  CharB const *b_end) -> int {
+  CharA const *a_start = a;
+  CharB const *b_start = b;
+  code_point ca = utf_traits<CharA>::decode(a, a_end);
+  code_point cb = utf_traits<CharB>::decode(b, b_end);
+  bool a_bad = ca == illegal || ca == incomplete;
+  bool b_bad = cb == illegal || cb == incomplete;
+  if (!a_bad && !b_bad) {
+    return ca == cb ? 0 : (ca < cb ? -1 : 1);
+  }
+  if (a_bad != b_bad) {
+    return a_bad ? 1 : -1;
+  }
+  return compare_units(a_start, a, b_start, b);
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Compare the code point sequences [a, a_end) and [b, b_end), which may
+/// be in different UTF encodings.
+///
+/// Returns a negative value, zero or a positive value if the first sequence
+/// is respectively lexicographically less than, equal to or greater than the
+/// second one, in code point order. This is the order of UTF-8 and UTF-32
+/// code units, but not of UTF-16 ones: a supplementary character encoded as a
+/// surrogate pair sorts after U+E000..U+FFFF here.
+///
+/// Ill-formed sequences sort after all code points, and among themselves by
+/// their code unit values, so that the result is 0 exactly when equal() is
+/// true, ill-formed input included. When both sides have the same code unit
+/// width, their common ASCII prefix is skipped a word at a time before the
+/// code point by code point walk starts.
+///
+template <typename CharA, typename CharB>
+auto compare(CharA const *a, CharA const *a_end, CharB const *b,
+             CharB const *b_end) -> int {
+  details::skip_common_ascii_if_same_width(
+      a, a_end, b, b_end,
+      std::integral_constant<bool, sizeof(CharA) == sizeof(CharB)>());
+  while (a != a_end && b != b_end) {
+    int result = details::compare_next(a, a_end, b, b_end);
+    if (result != 0) {
+      return result;
+    }
+  }
+  if (a != a_end) {
+    return 1;
+  }
+  return b != b_end ? -1 : 0;
+}
+
+/// \brief Compare two strings of any UTF encoding in code point order.
+template <typename CharA, typename TraitsA, typename AllocatorA, typename CharB,
+          typename TraitsB, typename AllocatorB>
+auto compare(std::basic_string<CharA, TraitsA, AllocatorA> const &a,
+             std::basic_string<CharB, TraitsB, AllocatorB> const &b) -> int {
+  return compare(a.data(), a.data() + a.size(), b.data(), b.data() + b.size());
+}
+
+///
+/// \brief Check that [a, a_end) and [b, b_end), which may be in different UTF
+/// encodings, hold the same code point sequence.
+///
+/// Ill-formed sequences are equal when they have the same code unit values,
+/// which keeps the relation reflexive, as unordered containers require, and
+/// consistent with compare(). Same width ranges skip their common ASCII prefix
+/// a word at a time.
+///
+template <typename CharA, typename CharB>
+auto equal(CharA const *a, CharA const *a_end, CharB const *b,
+           CharB const *b_end) -> bool {
+  if (sizeof(CharA) == sizeof(CharB) && (a_end - a) != (b_end - b)) {
+    return false;
+  }
+  details::skip_common_ascii_if_same_width(
+      a, a_end, b, b_end,
+      std::integral_constant<bool, sizeof(CharA) == sizeof(CharB)>());
+  while (a != a_end && b != b_end) {
+    if (details::compare_next(a, a_end, b, b_end) != 0) {
+      return false;
+    }
+  }
+  return a == a_end && b == b_end;
+}
+
+/// \brief Check that two strings of any UTF encoding hold the same code points.
+template <typename CharA, typename TraitsA, typename AllocatorA, typename CharB,
+          typename TraitsB, typename AllocatorB>
+auto equal(std::basic_string<CharA, TraitsA, AllocatorA> const &a,
+           std::basic_string<CharB, TraitsB, AllocatorB> const &b) -> bool {
+  return equal(a.data(), a.data() + a.size(), b.data(), b.data() + b.size());
+}
+
+}  // namespace utf
+}  // namespace nowide
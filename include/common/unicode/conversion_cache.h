@@ -0,0 +1,273 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file conversion_cache.h
+ *
+ * @brief Bounded, thread safe memoization of Unicode conversions of strings
+ * that are converted over and over again.
+ */
+
+#pragma once
+
+#include <common/unicode/encoding_utf.h>
+#include <common/unicode/swar.h>
+
+#include <atomic>
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>  // for std::move
+#include <vector>
+
+namespace nowide {
+namespace conv {
+
+/// \cond INTERNAL
+namespace details {
+
+///
+/// Fast, non cryptographic hash of the code units [begin, end), mixing a
+/// word at a time.
+///
+template <typename CharType>
+auto hash_units(CharType const *begin, CharType const *end) -> std::uint64_t {
+  using utf::details::load_word;
+  using utf::details::word_size;
+  const std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+  auto bytes = reinterpret_cast<unsigned char const *>(begin);
+  auto size = static_cast<std::size_t>(end - begin) * sizeof(CharType);
+  std::uint64_t h = size * multiplier;
+  for (; size >= word_size; bytes += word_size, size -= word_size) {
+    h = (h ^ load_word(bytes)) * multiplier;
+    h ^= h >> 32;
+  }
+  for (; size != 0; ++bytes, --size) {
+    h = (h ^ *bytes) * multiplier;
+  }
+  return h ^ (h >> 29);
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Bounded cache of the conversions of strings of \a CharIn to strings
+/// of \a CharOut.
+///
+/// Converting a string that is in the cache costs a hash of the source and a
+/// lookup, without any transcoding nor allocation: the converted strings are
+/// shared, immutable, and stay valid for as long as their holder keeps them,
+/// even after they are evicted from the cache.
+///
+/// The cache is split in shards selected by the hash of the source, each with
+/// its own lock, so that threads converting different strings seldom contend.
+/// A shard holds at most its share of the capacity; when it is full, the
+/// entry to evict is chosen with the CLOCK algorithm, an approximation of LRU
+/// that only sets a flag on a hit.
+///
+/// \code
+/// static nowide::conv::widen_cache cache;
+/// auto wide = cache.convert(path);  // std::shared_ptr<const std::wstring>
+/// \endcode
+///
+/// Conversion errors are not cached: conversion_error is thrown as by
+/// utf_to_utf() every time an ill-formed string is converted.
+///
+template <typename CharOut, typename CharIn>
+class basic_conversion_cache {
+ public:
+  /// The type of the strings to convert.
+  using source_type = std::basic_string<CharIn>;
+  /// The type of the converted strings.
+  using result_type = std::basic_string<CharOut>;
+  /// Shared handle to a converted string.
+  using pointer = std::shared_ptr<const result_type>;
+
+  /// Counters of the cache activity, since its creation or the last clear().
+  struct statistics {
+    /// Conversions served from the cache
+    std::uint64_t hits;
+    /// Conversions that had to transcode the source
+    std::uint64_t misses;
+    /// Entries dropped to make room for new ones
+    std::uint64_t evictions;
+  };
+
+  ///
+  /// \brief Create a cache of at most \a capacity strings, split in
+  /// \a shards shards.
+  ///
+  /// The number of shards is rounded up to a power of two, and each shard
+  /// holds at least one entry.
+  ///
+  explicit basic_conversion_cache(std::size_t capacity = 4096,
+                                  std::size_t shards = 16)
+      : shard_mask_(round_up(shards == 0 ? 1 : shards) - 1),
+        shards_(new shard[shard_mask_ + 1]) {
+    std::size_t per_shard = capacity / (shard_mask_ + 1);
+    for (std::size_t i = 0; i <= shard_mask_; ++i) {
+      shards_[i].slots.resize(per_shard == 0 ? 1 : per_shard);
+    }
+  }
+
+  /// Convert the text in range [begin, end), or find it in the cache.
+  auto convert(CharIn const *begin, CharIn const *end) -> pointer {
+    std::uint64_t hash = details::hash_units(begin, end);
+    shard &s = shards_[(hash >> 7) & shard_mask_];
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      slot *found = s.find(hash, begin, end);
+      if (found != nullptr) {
+        found->referenced = true;
+        s.hits.fetch_add(1, std::memory_order_relaxed);
+        return found->value;
+      }
+    }
+    // Convert without holding the lock
+    s.misses.fetch_add(1, std::memory_order_relaxed);
+    pointer value =
+        std::make_shared<const result_type>(utf_to_utf<CharOut>(begin, end));
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    slot *found = s.find(hash, begin, end);
+    if (found != nullptr) {
+      // Another thread inserted it in the meantime
+      found->referenced = true;
+      return found->value;
+    }
+    s.insert(hash, source_type(begin, end), value);
+    return value;
+  }
+
+  /// Convert the NUL terminated string \a str, or find it in the cache.
+  auto convert(CharIn const *str) -> pointer {
+    return convert(str, str + std::char_traits<CharIn>::length(str));
+  }
+
+  /// Convert the string \a str, or find it in the cache.
+  auto convert(source_type const &str) -> pointer {
+    return convert(str.data(), str.data() + str.size());
+  }
+
+  /// The activity counters, summed over all the shards.
+  auto stats() const -> statistics {
+    statistics result{0, 0, 0};
+    for (std::size_t i = 0; i <= shard_mask_; ++i) {
+      result.hits += shards_[i].hits.load(std::memory_order_relaxed);
+      result.misses += shards_[i].misses.load(std::memory_order_relaxed);
+      result.evictions += shards_[i].evictions.load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  /// The number of strings in the cache.
+  auto size() const -> std::size_t {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i <= shard_mask_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      result += shards_[i].index.size();
+    }
+    return result;
+  }
+
+  /// Empty the cache and reset its counters.
+  void clear() {
+    for (std::size_t i = 0; i <= shard_mask_; ++i) {
+      shard &s = shards_[i];
+      std::lock_guard<std::mutex> lock(s.mutex);
+      std::size_t slots = s.slots.size();
+      s.slots.clear();
+      s.slots.resize(slots);
+      s.index.clear();
+      s.hand = 0;
+      s.hits.store(0, std::memory_order_relaxed);
+      s.misses.store(0, std::memory_order_relaxed);
+      s.evictions.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  struct slot {
+    std::uint64_t hash{0};
+    source_type key;
+    pointer value;
+    bool referenced{false};
+  };
+
+  struct shard {
+    mutable std::mutex mutex;
+    std::vector<slot> slots;
+    /// Hash of the source to the index of its slot
+    std::unordered_multimap<std::uint64_t, std::size_t> index;
+    /// Next slot to consider for eviction
+    std::size_t hand{0};
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> evictions{0};
+
+    auto find(std::uint64_t hash, CharIn const *begin, CharIn const *end)
+        -> slot * {
+      auto range = index.equal_range(hash);
+      auto size = static_cast<std::size_t>(end - begin);
+      for (auto it = range.first; it != range.second; ++it) {
+        slot &candidate = slots[it->second];
+        if (candidate.key.size() == size &&
+            std::char_traits<CharIn>::compare(candidate.key.data(), begin,
+                                              size) == 0) {
+          return &candidate;
+        }
+      }
+      return nullptr;
+    }
+
+    void insert(std::uint64_t hash, source_type key, pointer value) {
+      // CLOCK: skip and clear the slots used since the hand last passed
+      while (slots[hand].value && slots[hand].referenced) {
+        slots[hand].referenced = false;
+        hand = (hand + 1) % slots.size();
+      }
+      slot &victim = slots[hand];
+      if (victim.value) {
+        auto range = index.equal_range(victim.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+          if (it->second == hand) {
+            index.erase(it);
+            break;
+          }
+        }
+        evictions.fetch_add(1, std::memory_order_relaxed);
+      }
+      victim.hash = hash;
+      victim.key = std::move(key);
+      victim.value = std::move(value);
+      victim.referenced = false;
+      index.emplace(hash, hand);
+      hand = (hand + 1) % slots.size();
+    }
+  };
+
+  static auto round_up(std::size_t n) -> std::size_t {
+    std::size_t result = 1;
+    while (result < n) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  std::size_t shard_mask_;
+  std::unique_ptr<shard[]> shards_;
+};
+
+/// Cache of UTF-8 to wide string conversions, as done by nowide::widen().
+using widen_cache = basic_conversion_cache<wchar_t, char>;
+/// Cache of wide to UTF-8 string conversions, as done by nowide::narrow().
+using narrow_cache = basic_conversion_cache<char, wchar_t>;
+
+}  // namespace conv
+}  // namespace nowide
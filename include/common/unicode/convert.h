@@ -26,48 +26,41 @@ template <typename CharOut, typename CharIn>
 auto basic_convert(CharOut *buffer, size_t buffer_size,
                    CharIn const *source_begin, CharIn const *source_end)
     -> CharOut * {
-  CharOut *rv = buffer;
   if (buffer_size == 0) {
     return nullptr;
   }
-  buffer_size--;
-  while (source_begin != source_end) {
-    using nowide::utf::code_point;
-    using nowide::utf::illegal;
-    using nowide::utf::incomplete;
-    using nowide::utf::utf_traits;
-    code_point c = utf_traits<CharIn>::template decode<CharIn const *>(
-        source_begin, source_end);
-    if (c == illegal || c == incomplete) {
-      rv = nullptr;
-      break;
-    }
-    size_t width = utf_traits<CharOut>::width(c);
-    if (buffer_size < width) {
-      rv = nullptr;
-      break;
-    }
-    buffer = utf_traits<CharOut>::template encode<CharOut *>(c, buffer);
-    buffer_size -= width;
-  }
-  *buffer = 0;
-  return rv;
+  nowide::conv::buffer_sink<CharOut> sink(buffer, buffer + buffer_size - 1);
+  nowide::conv::conversion_result result =
+      nowide::conv::utf_to_sink(source_begin, source_end, sink);
+  *sink.position() = 0;
+  return result == nowide::conv::conversion_result::ok ? buffer : nullptr;
 }
 
-/// \cond INTERNAL
-namespace details {
-//
-// wcslen defined only in C99... So we will not use it
-//
-template <typename Char>
-auto basic_strend(Char const *s) -> Char const * {
-  while (*s) {
-    s++;
+///
+/// \brief Template function that converts the NUL terminated UTF string
+/// \a source to the output \a buffer of size \a buffer_size.
+///
+/// The terminator is searched for a chunk at a time, just ahead of the
+/// conversion.
+///
+/// In case of success a NUL terminated string returned (buffer), otherwise 0 is
+/// returned.
+///
+/// If there is not enough room in the buffer or the source sequence contains
+/// invalid UTF 0 is returned, and the contend of the buffer is undefined.
+///
+template <typename CharOut, typename CharIn>
+auto basic_convert(CharOut *buffer, size_t buffer_size, CharIn const *source)
+    -> CharOut * {
+  if (buffer_size == 0) {
+    return nullptr;
   }
-  return s;
+  nowide::conv::buffer_sink<CharOut> sink(buffer, buffer + buffer_size - 1);
+  nowide::conv::conversion_result result =
+      nowide::conv::details::terminated_to_sink(source, sink);
+  *sink.position() = 0;
+  return result == nowide::conv::conversion_result::ok ? buffer : nullptr;
 }
-}  // namespace details
-/// \endcond
 
 ///
 /// Convert NUL terminated UTF source string to NUL terminated \a output string
@@ -78,8 +71,7 @@ auto basic_strend(Char const *s) -> Char const * {
 ///
 inline auto narrow(char *output, size_t output_size, wchar_t const *source)
     -> char * {
-  return basic_convert(output, output_size, source,
-                       details::basic_strend(source));
+  return basic_convert(output, output_size, source);
 }
 ///
 /// Convert UTF text in range [begin,end) to NUL terminated \a output string of
@@ -101,8 +93,7 @@ inline auto narrow(char *output, size_t output_size, wchar_t const *begin,
 ///
 inline auto widen(wchar_t *output, size_t output_size, char const *source)
     -> wchar_t * {
-  return basic_convert(output, output_size, source,
-                       details::basic_strend(source));
+  return basic_convert(output, output_size, source);
 }
 ///
 /// Convert UTF text in range [begin,end) to NUL terminated \a output string of
@@ -170,4 +161,223 @@ inline auto narrow(wchar_t const *begin, wchar_t const *end,
   return nowide::conv::utf_to_utf<char>(begin, end, alloc);
 }
 
+///
+/// Convert UTF-16 string to UTF-8 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(char16_t const *s, const Allocator &alloc = Allocator())
+    -> std::string {
+  return nowide::conv::utf_to_utf<char>(s, alloc);
+}
+///
+/// Convert UTF-16 string to UTF-8 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(std::u16string const &s,
+                   const Allocator &alloc = Allocator()) -> std::string {
+  return nowide::conv::utf_to_utf<char>(s, alloc);
+}
+///
+/// Convert UTF-16 text in range [begin,end) to UTF-8 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(char16_t const *begin, char16_t const *end,
+                   const Allocator &alloc = Allocator()) -> std::string {
+  return nowide::conv::utf_to_utf<char>(begin, end, alloc);
+}
+///
+/// Convert UTF-32 string to UTF-8 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(char32_t const *s, const Allocator &alloc = Allocator())
+    -> std::string {
+  return nowide::conv::utf_to_utf<char>(s, alloc);
+}
+///
+/// Convert UTF-32 string to UTF-8 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(std::u32string const &s,
+                   const Allocator &alloc = Allocator()) -> std::string {
+  return nowide::conv::utf_to_utf<char>(s, alloc);
+}
+///
+/// Convert UTF-32 text in range [begin,end) to UTF-8 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(char32_t const *begin, char32_t const *end,
+                   const Allocator &alloc = Allocator()) -> std::string {
+  return nowide::conv::utf_to_utf<char>(begin, end, alloc);
+}
+
+///
+/// Convert UTF-8 string to UTF-16 string, on all platforms (unlike widen(),
+/// which produces UTF-32 where wchar_t is 32 bits wide)
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char16_t>>
+inline auto widen_u16(char const *s, const Allocator &alloc = Allocator())
+    -> std::u16string {
+  return nowide::conv::utf_to_utf<char16_t>(s, alloc);
+}
+///
+/// Convert UTF-8 string to UTF-16 string, on all platforms
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char16_t>>
+inline auto widen_u16(std::string const &s,
+                      const Allocator &alloc = Allocator()) -> std::u16string {
+  return nowide::conv::utf_to_utf<char16_t>(s, alloc);
+}
+///
+/// Convert UTF-8 text in range [begin,end) to UTF-16 string, on all platforms
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char16_t>>
+inline auto widen_u16(char const *begin, char const *end,
+                      const Allocator &alloc = Allocator()) -> std::u16string {
+  return nowide::conv::utf_to_utf<char16_t>(begin, end, alloc);
+}
+///
+/// Convert UTF-8 string to UTF-32 string, on all platforms
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char32_t>>
+inline auto widen_u32(char const *s, const Allocator &alloc = Allocator())
+    -> std::u32string {
+  return nowide::conv::utf_to_utf<char32_t>(s, alloc);
+}
+///
+/// Convert UTF-8 string to UTF-32 string, on all platforms
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char32_t>>
+inline auto widen_u32(std::string const &s,
+                      const Allocator &alloc = Allocator()) -> std::u32string {
+  return nowide::conv::utf_to_utf<char32_t>(s, alloc);
+}
+///
+/// Convert UTF-8 text in range [begin,end) to UTF-32 string, on all platforms
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char32_t>>
+inline auto widen_u32(char const *begin, char const *end,
+                      const Allocator &alloc = Allocator()) -> std::u32string {
+  return nowide::conv::utf_to_utf<char32_t>(begin, end, alloc);
+}
+
+#if defined(__cpp_char8_t)
+///
+/// Convert C++20 UTF-8 string to UTF-8 string, validating it
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow(std::u8string const &s,
+                   const Allocator &alloc = Allocator()) -> std::string {
+  return nowide::conv::utf_to_utf<char>(s, alloc);
+}
+///
+/// Convert C++20 UTF-8 string to Wide - UTF-16/32 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<wchar_t>>
+inline auto widen(std::u8string const &s,
+                  const Allocator &alloc = Allocator()) -> std::wstring {
+  return nowide::conv::utf_to_utf<wchar_t>(s, alloc);
+}
+///
+/// Convert C++20 UTF-8 string to UTF-16 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char16_t>>
+inline auto widen_u16(std::u8string const &s,
+                      const Allocator &alloc = Allocator()) -> std::u16string {
+  return nowide::conv::utf_to_utf<char16_t>(s, alloc);
+}
+///
+/// Convert C++20 UTF-8 string to UTF-32 string
+///
+/// nowide::conv::conversion_error is thrown in a case of a error
+///
+template <typename Allocator = std::allocator<char32_t>>
+inline auto widen_u32(std::u8string const &s,
+                      const Allocator &alloc = Allocator()) -> std::u32string {
+  return nowide::conv::utf_to_utf<char32_t>(s, alloc);
+}
+#endif  // __cpp_char8_t
+
+///
+/// Convert the valid Wide - UTF-16/32 string to UTF-8 string, skipping all
+/// validity checks.
+///
+/// This is for already validated input only: ill-formed input is undefined
+/// behavior (caught by assertions at the audit assertion level).
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow_unchecked(std::wstring const &s,
+                             const Allocator &alloc = Allocator())
+    -> std::string {
+  return nowide::conv::utf_to_utf_unchecked<char>(s, alloc);
+}
+///
+/// Convert the valid Wide - UTF-16/32 text in range [begin,end) to UTF-8
+/// string, skipping all validity checks.
+///
+/// This is for already validated input only: ill-formed input is undefined
+/// behavior (caught by assertions at the audit assertion level).
+///
+template <typename Allocator = std::allocator<char>>
+inline auto narrow_unchecked(wchar_t const *begin, wchar_t const *end,
+                             const Allocator &alloc = Allocator())
+    -> std::string {
+  return nowide::conv::utf_to_utf_unchecked<char>(begin, end, alloc);
+}
+///
+/// Convert the valid UTF-8 string to Wide - UTF-16/32 string, skipping all
+/// validity checks.
+///
+/// This is for already validated input only: ill-formed input is undefined
+/// behavior (caught by assertions at the audit assertion level).
+///
+template <typename Allocator = std::allocator<wchar_t>>
+inline auto widen_unchecked(std::string const &s,
+                            const Allocator &alloc = Allocator())
+    -> std::wstring {
+  return nowide::conv::utf_to_utf_unchecked<wchar_t>(s, alloc);
+}
+///
+/// Convert the valid UTF-8 text in range [begin,end) to Wide - UTF-16/32
+/// string, skipping all validity checks.
+///
+/// This is for already validated input only: ill-formed input is undefined
+/// behavior (caught by assertions at the audit assertion level).
+///
+template <typename Allocator = std::allocator<wchar_t>>
+inline auto widen_unchecked(char const *begin, char const *end,
+                            const Allocator &alloc = Allocator())
+    -> std::wstring {
+  return nowide::conv::utf_to_utf_unchecked<wchar_t>(begin, end, alloc);
+}
+
 }  // namespace nowide
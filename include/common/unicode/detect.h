@@ -0,0 +1,259 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file detect.h
+ *
+ * @brief Detection of the UTF encoding of a raw byte buffer, from its byte
+ * order mark or, in its absence, from a bounded sample of its content.
+ */
+
+#pragma once
+
+#include <common/unicode/swar.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types
+
+namespace nowide {
+namespace utf {
+
+/// The encodings that can be reported by the detection functions.
+enum class encoding {
+  unknown,  ///< Not recognized as any UTF encoding
+  utf8,     ///< UTF-8
+  utf16le,  ///< UTF-16, little endian
+  utf16be,  ///< UTF-16, big endian
+  utf32le,  ///< UTF-32, little endian
+  utf32be   ///< UTF-32, big endian
+};
+
+/// The result of an encoding detection.
+struct detected_encoding {
+  /// The detected encoding, or encoding::unknown.
+  encoding type;
+  /// How sure the detection is, from 0 (a guess at best) to 100 (BOM).
+  int confidence;
+  /// Size in bytes of the byte order mark at the start of the data, if any.
+  std::size_t bom_size;
+};
+
+/// Default number of bytes sampled by detect_encoding().
+static const std::size_t default_detection_sample = 4096;
+
+/// \cond INTERNAL
+namespace details {
+
+/// Count the zero bytes of [p, p + size) by offset modulo 4.
+inline void zero_byte_profile(unsigned char const *p, std::size_t size,
+                              std::size_t (&counts)[4]) {
+  counts[0] = counts[1] = counts[2] = counts[3] = 0;
+  std::size_t i = 0;
+  if (size >= word_size) {
+    word_type const masks[4] = {offset_mask(4, 0), offset_mask(4, 1),
+                                offset_mask(4, 2), offset_mask(4, 3)};
+    for (; i + word_size <= size; i += word_size) {
+      word_type zeros = zero_bytes(load_word(p + i));
+      if (NOWIDE_LIKELY(zeros == 0)) {
+        continue;
+      }
+      for (int k = 0; k < 4; ++k) {
+        counts[k] += static_cast<std::size_t>(popcount(zeros & masks[k]));
+      }
+    }
+  }
+  for (; i < size; ++i) {
+    if (p[i] == 0) {
+      ++counts[i % 4];
+    }
+  }
+}
+
+/// Result of scanning a sample as UTF-8.
+enum class utf8_sample { invalid, ascii, multibyte };
+
+///
+/// Check [begin, end) with the UTF-8 decoding rules. An incomplete sequence at
+/// the end is accepted when the sample was cut from a larger input.
+///
+inline auto scan_utf8_sample(char const *begin, char const *end,
+                             bool truncated) -> utf8_sample {
+  bool multibyte = false;
+  while (begin != end) {
+    begin = ascii_prefix(begin, end);
+    if (begin == end) {
+      break;
+    }
+    code_point c = utf_traits<char>::decode(begin, end);
+    if (c == illegal || (c == incomplete && !truncated)) {
+      return utf8_sample::invalid;
+    }
+    multibyte = true;
+  }
+  return multibyte ? utf8_sample::multibyte : utf8_sample::ascii;
+}
+
+/// Check that [p, p + size) is well formed UTF-16 in the given byte order.
+inline auto is_utf16_sample(unsigned char const *p, std::size_t size,
+                            bool little_endian, bool truncated) -> bool {
+  using traits = utf_traits<char16_t>;
+  if (size % 2 != 0 && !truncated) {
+    return false;
+  }
+  std::size_t units = size / 2;
+  bool pending = false;
+  for (std::size_t i = 0; i < units; ++i, p += 2) {
+    auto w = static_cast<std::uint16_t>(
+        little_endian ? (p[0] | (p[1] << 8)) : ((p[0] << 8) | p[1]));
+    if (pending != traits::is_second_surrogate(w)) {
+      return false;
+    }
+    pending = traits::is_first_surrogate(w);
+  }
+  return !pending || truncated;
+}
+
+/// Check that [p, p + size) is well formed UTF-32 in the given byte order.
+inline auto is_utf32_sample(unsigned char const *p, std::size_t size,
+                            bool little_endian, bool truncated) -> bool {
+  if (size % 4 != 0 && !truncated) {
+    return false;
+  }
+  for (std::size_t units = size / 4; units != 0; --units, p += 4) {
+    auto c = little_endian
+                 ? static_cast<code_point>(p[0] | (p[1] << 8) | (p[2] << 16) |
+                                           (code_point(p[3]) << 24))
+                 : static_cast<code_point>((code_point(p[0]) << 24) |
+                                           (p[1] << 16) | (p[2] << 8) | p[3]);
+    if (!is_valid_codepoint(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Detect the encoding of \a data from its byte order mark.
+///
+/// A UTF-32LE BOM takes precedence over the UTF-16LE BOM it starts with. If
+/// no BOM is present, the result is encoding::unknown with a confidence and
+/// bom_size of 0.
+///
+inline auto detect_bom(void const *data, std::size_t size)
+    -> detected_encoding {
+  auto p = static_cast<unsigned char const *>(data);
+  if (size >= 4 && p[0] == 0xFF && p[1] == 0xFE && p[2] == 0 && p[3] == 0) {
+    return {encoding::utf32le, 100, 4};
+  }
+  if (size >= 4 && p[0] == 0 && p[1] == 0 && p[2] == 0xFE && p[3] == 0xFF) {
+    return {encoding::utf32be, 100, 4};
+  }
+  if (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) {
+    return {encoding::utf8, 100, 3};
+  }
+  if (size >= 2 && p[0] == 0xFF && p[1] == 0xFE) {
+    return {encoding::utf16le, 100, 2};
+  }
+  if (size >= 2 && p[0] == 0xFE && p[1] == 0xFF) {
+    return {encoding::utf16be, 100, 2};
+  }
+  return {encoding::unknown, 0, 0};
+}
+
+///
+/// \brief Detect the UTF encoding of \a data.
+///
+/// The byte order mark is used when present. Otherwise, at most \a sample_size
+/// bytes from the start of the data are examined: the distribution of zero
+/// bytes by position tells UTF-16 and UTF-32 (and their byte order) apart
+/// from UTF-8, and the candidate is then checked against the decoding rules
+/// of its encoding.
+///
+/// The returned confidence is 100 for a BOM, high for well formed text with
+/// a clear zero byte pattern or with non ASCII UTF-8 sequences, and low when
+/// the content is only compatible with the reported encoding. Data that is
+/// well formed in none of the encodings is reported as encoding::unknown.
+///
+inline auto detect_encoding(void const *data, std::size_t size,
+                            std::size_t sample_size = default_detection_sample)
+    -> detected_encoding {
+  detected_encoding bom = detect_bom(data, size);
+  if (bom.type != encoding::unknown) {
+    return bom;
+  }
+  if (size == 0) {
+    return {encoding::unknown, 0, 0};
+  }
+
+  auto p = static_cast<unsigned char const *>(data);
+  std::size_t n = size < sample_size ? size : sample_size;
+  bool truncated = n < size;
+
+  std::size_t zeros[4];
+  details::zero_byte_profile(p, n, zeros);
+  std::size_t even_zeros = zeros[0] + zeros[2];
+  std::size_t odd_zeros = zeros[1] + zeros[3];
+
+  if (even_zeros + odd_zeros == 0) {
+    auto text = reinterpret_cast<char const *>(p);
+    switch (details::scan_utf8_sample(text, text + n, truncated)) {
+      case details::utf8_sample::multibyte:
+        return {encoding::utf8, 95, 0};
+      case details::utf8_sample::ascii:
+        return {encoding::utf8, 90, 0};
+      case details::utf8_sample::invalid:
+        break;
+    }
+    // Text in scripts outside of Latin-1 has no zero bytes in UTF-16 either.
+    bool le = details::is_utf16_sample(p, n, true, truncated);
+    bool be = details::is_utf16_sample(p, n, false, truncated);
+    if (le != be) {
+      return {le ? encoding::utf16le : encoding::utf16be, 30, 0};
+    }
+    return {encoding::unknown, 0, 0};
+  }
+
+  std::size_t units32 = n / 4;
+  if (units32 != 0) {
+    // The most significant byte of a UTF-32 code unit is always zero, and so
+    // is the next one for all of the BMP.
+    if (zeros[3] == units32 &&
+        details::is_utf32_sample(p, n, true, truncated)) {
+      return {encoding::utf32le, zeros[2] * 2 >= units32 ? 90 : 60, 0};
+    }
+    if (zeros[0] == units32 &&
+        details::is_utf32_sample(p, n, false, truncated)) {
+      return {encoding::utf32be, zeros[1] * 2 >= units32 ? 90 : 60, 0};
+    }
+  }
+
+  std::size_t units16 = n / 2;
+  if (units16 != 0 && even_zeros != odd_zeros) {
+    bool le = odd_zeros > even_zeros;
+    std::size_t high = le ? odd_zeros : even_zeros;
+    std::size_t low = le ? even_zeros : odd_zeros;
+    if (details::is_utf16_sample(p, n, le, truncated)) {
+      // Scale with how consistently one side of the code units is zero.
+      auto confidence = static_cast<int>(40 + (50 * (high - low)) / units16);
+      return {le ? encoding::utf16le : encoding::utf16be, confidence, 0};
+    }
+  }
+
+  // Zero bytes without any recognizable pattern: UTF-8 with embedded NULs at
+  // best.
+  auto text = reinterpret_cast<char const *>(p);
+  if (details::scan_utf8_sample(text, text + n, truncated) !=
+      details::utf8_sample::invalid) {
+    return {encoding::utf8, 20, 0};
+  }
+  return {encoding::unknown, 0, 0};
+}
+
+}  // namespace utf
+}  // namespace nowide
@@ -7,17 +7,373 @@
 //
 #pragma once
 
+#include <common/assert.h>
 #include <common/unicode/encoding_errors.h>
+#include <common/unicode/swar.h>
 #include <common/unicode/utf.h>
 
+#include <cstring>  // for std::memcpy
 #include <iterator>
 #include <string>
+#include <type_traits>
 
 namespace nowide {
 
 /// Namespace holding conversion functions between different unicode encodings.
 namespace conv {
 
+/// \cond INTERNAL
+namespace details {
+
+///
+/// Upper bound of the number of code units needed to encode any valid text of
+/// \a size code units of type CharIn with code units of type CharOut.
+///
+template <typename CharOut, typename CharIn>
+constexpr auto max_output_units(std::size_t size) -> std::size_t {
+  return sizeof(CharOut) == 1
+             ? (sizeof(CharIn) == 1 ? size
+                                    : (sizeof(CharIn) == 2 ? 3 * size
+                                                           : 4 * size))
+             : (sizeof(CharOut) == 2 && sizeof(CharIn) == 4 ? 2 * size
+                                                            : size);
+}
+
+///
+/// Copy the ASCII code units [begin, end) to \a out, widening or narrowing
+/// them as needed. The loop is trivially vectorizable.
+///
+template <typename CharOut, typename CharIn>
+auto copy_ascii(CharIn const *begin, CharIn const *end, CharOut *out)
+    -> CharOut * {
+  for (; begin != end; ++begin, ++out) {
+    *out = static_cast<CharOut>(*begin);
+  }
+  return out;
+}
+
+/// Number of input code units converted per block by utf_to_sink().
+static const std::size_t conversion_block_size = 1024;
+
+///
+/// Decoder used by the conversion kernels: same contract as
+/// utf_traits::decode(), with the common cases inlined for each input width.
+///
+template <typename CharIn, std::size_t size = sizeof(CharIn)>
+struct fast_decoder {
+  static auto decode(CharIn const *&p, CharIn const *e) -> utf::code_point {
+    return utf::utf_traits<CharIn>::template decode<CharIn const *>(p, e);
+  }
+};
+
+template <typename CharIn>
+struct fast_decoder<CharIn, 1> {
+  static auto decode(CharIn const *&p, CharIn const *e) -> utf::code_point {
+    auto lead = static_cast<unsigned char>(*p);
+    // Two byte sequences (Latin, Greek, Cyrillic, Hebrew, Arabic...)
+    if (lead >= 0xC2 && lead <= 0xDF && e - p >= 2) {
+      auto trail = static_cast<unsigned char>(p[1]);
+      if ((trail & 0xC0) == 0x80) {
+        p += 2;
+        return (utf::code_point(lead & 0x1F) << 6) | (trail & 0x3F);
+      }
+    }
+    // Three byte sequences whose lead byte alone rules out overlong forms and
+    // surrogates (most of the BMP, CJK included)
+    if (lead >= 0xE1 && lead <= 0xEF && lead != 0xED && e - p >= 3) {
+      auto trail1 = static_cast<unsigned char>(p[1]);
+      auto trail2 = static_cast<unsigned char>(p[2]);
+      if ((trail1 & 0xC0) == 0x80 && (trail2 & 0xC0) == 0x80) {
+        p += 3;
+        return (utf::code_point(lead & 0x0F) << 12) |
+               (utf::code_point(trail1 & 0x3F) << 6) | (trail2 & 0x3F);
+      }
+    }
+    return utf::utf_traits<CharIn>::template decode<CharIn const *>(p, e);
+  }
+};
+
+///
+/// Convert the code points starting in [begin, stop) to \a out, decoding
+/// sequences up to \a end, and return the end of the output.
+///
+/// ASCII runs are widened or narrowed in bulk, and the other code points go
+/// through the fast_decoder. The conversion stops at the first sequence that
+/// does not decode, either because it is ill-formed or because it is cut by
+/// \a end, leaving \a begin on its first code unit. \a out must have room for
+/// max_output_units(stop - begin + max_width) code units.
+///
+template <typename CharOut, typename CharIn>
+auto convert_units(CharIn const *&begin, CharIn const *stop, CharIn const *end,
+                   CharOut *out) -> CharOut * {
+  while (begin < stop) {
+    CharIn const *ascii_end = utf::details::ascii_prefix(begin, stop);
+    out = copy_ascii(begin, ascii_end, out);
+    begin = ascii_end;
+    if (begin == stop) {
+      break;
+    }
+    CharIn const *start = begin;
+    utf::code_point c = fast_decoder<CharIn>::decode(begin, end);
+    if (c == utf::illegal || c == utf::incomplete) {
+      begin = start;
+      break;
+    }
+    out = utf::utf_traits<CharOut>::template encode<CharOut *>(c, out);
+  }
+  return out;
+}
+
+///
+/// Same contract as convert_units(), when both sides use the same encoding:
+/// the input is only validated, with ASCII runs skipped a word at a time,
+/// and the valid part is then copied with a single memcpy.
+///
+template <typename CharOut, typename CharIn>
+auto copy_valid_units(CharIn const *&begin, CharIn const *stop,
+                      CharIn const *end, CharOut *out) -> CharOut * {
+  static_assert(sizeof(CharOut) == sizeof(CharIn), "same encoding only");
+  CharIn const *const first = begin;
+  while (begin < stop) {
+    begin = utf::details::ascii_prefix(begin, stop);
+    if (begin == stop) {
+      break;
+    }
+    CharIn const *start = begin;
+    utf::code_point c = fast_decoder<CharIn>::decode(begin, end);
+    if (c == utf::illegal || c == utf::incomplete) {
+      begin = start;
+      break;
+    }
+  }
+  auto count = static_cast<std::size_t>(begin - first);
+  std::memcpy(out, first, count * sizeof(CharIn));
+  return out + count;
+}
+
+template <typename CharOut, typename CharIn>
+auto convert_block(CharIn const *&begin, CharIn const *stop, CharIn const *end,
+                   CharOut *out, std::true_type /*same_width*/) -> CharOut * {
+  return copy_valid_units(begin, stop, end, out);
+}
+
+template <typename CharOut, typename CharIn>
+auto convert_block(CharIn const *&begin, CharIn const *stop, CharIn const *end,
+                   CharOut *out, std::false_type /*same_width*/) -> CharOut * {
+  return convert_units(begin, stop, end, out);
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Sink writing converted text at the end of a resizable, contiguous
+/// container, such as std::basic_string, std::vector or a fmt-like memory
+/// buffer.
+///
+/// For each block, the container is grown by the worst case size of the
+/// block, written to through a plain pointer, and shrunk back to what was
+/// actually written, so reserving capacity ahead avoids all reallocations.
+/// Otherwise the capacity is at least doubled when it runs out, whatever the
+/// growth policy of the container.
+///
+/// Sinks are used by utf_to_sink(), and any type with the same members can be
+/// used as well, e.g. to convert straight into an arena or a network buffer:
+///
+/// - `char_type`, the type of the code units it receives,
+/// - `char_type *prepare(std::size_t n)` returning room for \a n more code
+///   units, or nullptr if there is not that much room,
+/// - `void commit(char_type *end)` telling that the room returned by the last
+///   call to prepare() was written up to \a end.
+///
+template <typename Container>
+class resizable_sink {
+ public:
+  using char_type = typename Container::value_type;
+
+  /// Append to \a container, which must outlive the sink.
+  explicit resizable_sink(Container &container) : container_(container) {}
+
+  auto prepare(std::size_t n) -> char_type * {
+    used_ = container_.size();
+    std::size_t capacity = container_.capacity();
+    if (used_ + n > capacity) {
+      container_.reserve(used_ + n > 2 * capacity ? used_ + n : 2 * capacity);
+    }
+    container_.resize(used_ + n);
+    return &container_[0] + used_;
+  }
+
+  void commit(char_type *end) {
+    container_.resize(used_ + static_cast<std::size_t>(
+                                  end - (&container_[0] + used_)));
+  }
+
+ private:
+  Container &container_;
+  std::size_t used_{0};
+};
+
+///
+/// \brief Sink writing converted text to the fixed buffer [first, last).
+///
+template <typename CharOut>
+class buffer_sink {
+ public:
+  using char_type = CharOut;
+
+  buffer_sink(CharOut *first, CharOut *last) : position_(first), last_(last) {}
+
+  auto prepare(std::size_t n) -> CharOut * {
+    return n <= static_cast<std::size_t>(last_ - position_) ? position_
+                                                           : nullptr;
+  }
+
+  void commit(CharOut *end) { position_ = end; }
+
+  /// The end of the text written so far.
+  auto position() const -> CharOut * { return position_; }
+
+ private:
+  CharOut *position_;
+  CharOut *last_;
+};
+
+///
+/// \brief Sink writing converted text to an output iterator, through a small
+/// staging buffer.
+///
+template <typename CharOut, typename OutputIterator>
+class output_iterator_sink {
+ public:
+  using char_type = CharOut;
+
+  explicit output_iterator_sink(OutputIterator out) : out_(out) {}
+
+  auto prepare(std::size_t n) -> CharOut * {
+    return n <= staging_size ? staging_ : nullptr;
+  }
+
+  void commit(CharOut *end) {
+    for (CharOut const *p = staging_; p != end; ++p, ++out_) {
+      *out_ = *p;
+    }
+  }
+
+  /// The output iterator, past the text written so far.
+  auto base() const -> OutputIterator { return out_; }
+
+ private:
+  static const std::size_t staging_size = 1024;
+  OutputIterator out_;
+  CharOut staging_[staging_size];
+};
+
+/// The outcome of utf_to_sink().
+enum class conversion_result {
+  ok,       ///< All the input was converted
+  invalid,  ///< The input is ill-formed
+  no_room   ///< The sink is full
+};
+
+///
+/// \brief Convert the Unicode text in range [begin,end) to the encoding of
+/// the code units of \a sink, writing it block by block.
+///
+/// Each block is converted straight into the room obtained from the sink:
+/// no intermediate string is built and nothing is copied afterwards. When the
+/// sink cannot hold the worst case size of a block, the block is halved, and
+/// the last code points that fit in a nearly full sink are written one at a
+/// time. When the input and the output use the same encoding (e.g. UTF-8 to
+/// UTF-8, or char32_t to a 32 bit wchar_t), blocks are validated and copied
+/// with memcpy instead of being decoded and encoded again. On failure, the
+/// text before the offending code point has been written to the sink.
+///
+template <typename CharIn, typename Sink>
+auto utf_to_sink(CharIn const *begin, CharIn const *end, Sink &sink)
+    -> conversion_result {
+  using char_out = typename Sink::char_type;
+  while (begin != end) {
+    auto block = static_cast<std::size_t>(end - begin);
+    if (block > details::conversion_block_size) {
+      block = details::conversion_block_size;
+    }
+    char_out *first = nullptr;
+    for (;;) {
+      // The last sequence of the block may extend past its end, but not past
+      // the end of the input
+      std::size_t span = block + utf::utf_traits<CharIn>::max_width;
+      auto left = static_cast<std::size_t>(end - begin);
+      first = sink.prepare(details::max_output_units<char_out, CharIn>(
+          span < left ? span : left));
+      if (first != nullptr || block <= 16) {
+        break;
+      }
+      block /= 2;
+    }
+    if (first == nullptr) {
+      utf::code_point c =
+          utf::utf_traits<CharIn>::template decode<CharIn const *>(begin, end);
+      if (c == utf::illegal || c == utf::incomplete) {
+        return conversion_result::invalid;
+      }
+      first = sink.prepare(utf::utf_traits<char_out>::width(c));
+      if (first == nullptr) {
+        return conversion_result::no_room;
+      }
+      sink.commit(
+          utf::utf_traits<char_out>::template encode<char_out *>(c, first));
+      continue;
+    }
+    CharIn const *block_end = begin + block;
+    sink.commit(details::convert_block(
+        begin, block_end, end, first,
+        std::integral_constant<bool, sizeof(char_out) == sizeof(CharIn)>()));
+    if (begin < block_end) {
+      return conversion_result::invalid;
+    }
+  }
+  return conversion_result::ok;
+}
+
+/// \cond INTERNAL
+namespace details {
+
+/// Number of input code units scanned for the terminator at a time by
+/// terminated_to_sink().
+static const std::size_t terminated_chunk_size = 4 * conversion_block_size;
+
+///
+/// Same as utf_to_sink(), for the NUL terminated string \a str.
+///
+/// The terminator is searched for one chunk at a time, and each chunk is
+/// converted by utf_to_sink() while it is still in cache. A chunk that does
+/// not end at the terminator is cut back to the start of the code point that
+/// straddles its end, if any, which is then converted with the next chunk.
+///
+template <typename CharIn, typename Sink>
+auto terminated_to_sink(CharIn const *str, Sink &sink) -> conversion_result {
+  using traits = utf::utf_traits<CharIn>;
+  for (;;) {
+    CharIn const *end =
+        utf::details::find_terminator(str, terminated_chunk_size);
+    // All of [str, end) is non-zero, so *end is part of the string
+    CharIn const *stop = end;
+    for (std::size_t back = 1;
+         back < traits::max_width && traits::is_trail(*stop); ++back) {
+      --stop;
+    }
+    conversion_result result = utf_to_sink(str, stop, sink);
+    if (result != conversion_result::ok || *end == 0) {
+      return result;
+    }
+    str = stop;
+  }
+}
+
+}  // namespace details
+/// \endcond
+
 /// Convert a Unicode text in range [begin,end) to other Unicode encoding
 template <typename CharOut, typename CharIn,
           typename Traits = std::char_traits<CharOut>,
@@ -28,36 +384,30 @@ auto utf_to_utf(CharIn const *begin, CharIn const *end,
   std::basic_string<CharOut, Traits, Allocator> result(alloc);
   auto range_size = end - begin;
   if (range_size > 0) {
-    result.reserve(
-        static_cast<
-            typename std::basic_string<CharOut, Traits, Allocator>::size_type>(
-            range_size));
-  }
-  using inserter_type =
-      std::back_insert_iterator<std::basic_string<CharOut, Traits, Allocator>>;
-  inserter_type inserter(result);
-  utf::code_point c = 0;
-  while (begin != end) {
-    c = utf::utf_traits<CharIn>::template decode<CharIn const *>(begin, end);
-    if (c == utf::illegal || c == utf::incomplete) {
-      throw conversion_error();
-    }
-    utf::utf_traits<CharOut>::template encode<inserter_type>(c, inserter);
+    // Room for the worst case, so that the result is allocated once
+    result.reserve(details::max_output_units<CharOut, CharIn>(
+        static_cast<std::size_t>(range_size)));
+  }
+  resizable_sink<std::basic_string<CharOut, Traits, Allocator>> sink(result);
+  if (utf_to_sink(begin, end, sink) != conversion_result::ok) {
+    throw conversion_error();
   }
   return result;
 }
 
+///
 /// Convert a Unicode NUL terminated string \a str other Unicode encoding
+///
+/// The length of \a str is computed first, so that the result is allocated
+/// once and the conversion runs on the range.
+///
 template <typename CharOut, typename CharIn,
           typename Traits = std::char_traits<CharOut>,
           class Allocator = std::allocator<CharOut>>
 auto utf_to_utf(CharIn const *str, const Allocator &alloc = Allocator())
     -> std::basic_string<CharOut, Traits, Allocator> {
-  CharIn const *end = str;
-  while (*end) {
-    end++;
-  }
-  return utf_to_utf<CharOut, CharIn, Traits, Allocator>(str, end, alloc);
+  return utf_to_utf<CharOut, CharIn, Traits, Allocator>(
+      str, str + std::char_traits<CharIn>::length(str), alloc);
 }
 
 /// Convert a Unicode string \a str other Unicode encoding
@@ -71,5 +421,66 @@ auto utf_to_utf(std::basic_string<CharIn> const &str,
       str.c_str(), str.c_str() + str.size(), alloc);
 }
 
+///
+/// \brief Convert the valid Unicode text in range [begin,end) to other Unicode
+/// encoding, skipping all validity checks.
+///
+/// This is meant for text that is known to be well formed, such as strings
+/// that were validated when they entered the program. The input is decoded
+/// with utf_traits::decode_valid() and ASCII runs are converted in bulk,
+/// straight into the result buffer.
+///
+/// If the input is not valid the behavior is undefined. At the audit
+/// assertion level, every code point is checked against the result of the
+/// fully checking decode() with ASAP_ASSERT_AUDIT.
+///
+template <typename CharOut, typename CharIn,
+          typename Traits = std::char_traits<CharOut>,
+          class Allocator = std::allocator<CharOut>>
+auto utf_to_utf_unchecked(CharIn const *begin, CharIn const *end,
+                          const Allocator &alloc = Allocator())
+    -> std::basic_string<CharOut, Traits, Allocator> {
+  using string_type = std::basic_string<CharOut, Traits, Allocator>;
+  string_type result(alloc);
+  if (begin == end) {
+    return result;
+  }
+  result.resize(static_cast<typename string_type::size_type>(
+      details::max_output_units<CharOut, CharIn>(
+          static_cast<std::size_t>(end - begin))));
+  CharOut *out = &result[0];
+  while (begin != end) {
+    CharIn const *ascii_end = utf::details::ascii_prefix(begin, end);
+    out = details::copy_ascii(begin, ascii_end, out);
+    begin = ascii_end;
+    if (begin == end) {
+      break;
+    }
+#if ASAP_ASSERT_LEVEL >= ASAP_ASSERT_LEVEL_AUDIT
+    CharIn const *checked = begin;
+    utf::code_point expected =
+        utf::utf_traits<CharIn>::template decode<CharIn const *>(checked, end);
+#endif
+    utf::code_point c =
+        utf::utf_traits<CharIn>::template decode_valid<CharIn const *>(begin);
+    ASAP_ASSERT_AUDIT(c == expected && begin == checked);
+    out = utf::utf_traits<CharOut>::template encode<CharOut *>(c, out);
+  }
+  result.resize(static_cast<typename string_type::size_type>(out - &result[0]));
+  return result;
+}
+
+/// Convert the valid Unicode string \a str to other Unicode encoding, skipping
+/// all validity checks.
+template <typename CharOut, typename CharIn,
+          typename Traits = std::char_traits<CharOut>,
+          class Allocator = std::allocator<CharOut>>
+auto utf_to_utf_unchecked(std::basic_string<CharIn> const &str,
+                          const Allocator &alloc = Allocator())
+    -> std::basic_string<CharOut, Traits, Allocator> {
+  return utf_to_utf_unchecked<CharOut, CharIn, Traits, Allocator>(
+      str.c_str(), str.c_str() + str.size(), alloc);
+}
+
 }  // namespace conv
 }  // namespace nowide
@@ -0,0 +1,142 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file hash.h
+ *
+ * @brief Hashing of Unicode text by code point, independently of its UTF
+ * encoding.
+ */
+
+#pragma once
+
+#include <common/unicode/compare.h>
+#include <common/unicode/swar.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types
+#include <string>
+
+namespace nowide {
+namespace utf {
+
+/// \cond INTERNAL
+namespace details {
+
+/// FNV-1a, fed with one code point at a time.
+struct code_point_hasher {
+  std::uint64_t state{0xCBF29CE484222325ULL};
+
+  void add(code_point c) { state = (state ^ c) * 0x100000001B3ULL; }
+};
+
+/// A range of code units, as seen by the hash and equality functors.
+template <typename CharType>
+struct unit_range {
+  CharType const *begin;
+  CharType const *end;
+};
+
+template <typename CharType, typename Traits, typename Allocator>
+auto make_unit_range(std::basic_string<CharType, Traits, Allocator> const &s)
+    -> unit_range<CharType> {
+  return {s.data(), s.data() + s.size()};
+}
+
+template <typename CharType>
+auto make_unit_range(CharType const *s) -> unit_range<CharType> {
+  return {s, s + std::char_traits<CharType>::length(s)};
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Hash the code point sequence encoded in [begin, end).
+///
+/// The value only depends on the code points, so the UTF-8, UTF-16 and UTF-32
+/// forms of the same text hash to the same value and a key can be probed
+/// without converting it first. ASCII runs, located a word at a time, are
+/// hashed without going through the decoder.
+///
+/// Each ill-formed sequence contributes a marker followed by its code unit
+/// values, matching equal(), for which ill-formed sequences are equal when
+/// their code units are.
+///
+template <typename CharType>
+auto hash_code_points(CharType const *begin, CharType const *end)
+    -> std::size_t {
+  using unsigned_type = typename std::make_unsigned<CharType>::type;
+  details::code_point_hasher hasher;
+  while (begin != end) {
+    CharType const *ascii_end = details::ascii_prefix(begin, end);
+    for (; begin != ascii_end; ++begin) {
+      hasher.add(static_cast<unsigned_type>(*begin));
+    }
+    if (begin != end) {
+      CharType const *start = begin;
+      code_point c = utf_traits<CharType>::decode(begin, end);
+      if (c == illegal || c == incomplete) {
+        // Consistent with equal(), which compares ill-formed code units
+        hasher.add(illegal);
+        for (; start != begin; ++start) {
+          hasher.add(static_cast<unsigned_type>(*start));
+        }
+      } else {
+        hasher.add(c);
+      }
+    }
+  }
+  return static_cast<std::size_t>(hasher.state);
+}
+
+/// \brief Hash the code point sequence of the string \a str.
+template <typename CharType, typename Traits, typename Allocator>
+auto hash_code_points(std::basic_string<CharType, Traits, Allocator> const &str)
+    -> std::size_t {
+  return hash_code_points(str.data(), str.data() + str.size());
+}
+
+///
+/// \brief Transparent hash functor for strings of any UTF encoding, consistent
+/// with code_point_equal.
+///
+/// Accepts std::basic_string of char, wchar_t, char16_t and char32_t as well
+/// as NUL terminated strings of these types. Unordered containers use the
+/// is_transparent tag for heterogeneous lookup from C++20 on, e.g. to find a
+/// UTF-16 key in a map keyed by UTF-8 strings without converting it.
+///
+struct code_point_hash {
+  using is_transparent = void;
+
+  template <typename String>
+  auto operator()(String const &str) const -> std::size_t {
+    auto range = details::make_unit_range(str);
+    return hash_code_points(range.begin, range.end);
+  }
+};
+
+///
+/// \brief Transparent equality functor for strings of any UTF encoding,
+/// comparing them code point by code point without converting them.
+///
+/// An equivalence relation, as unordered containers require: ill-formed
+/// sequences compare by their code unit values, so that a malformed key
+/// matches itself.
+///
+struct code_point_equal {
+  using is_transparent = void;
+
+  template <typename StringA, typename StringB>
+  auto operator()(StringA const &a, StringB const &b) const -> bool {
+    auto ra = details::make_unit_range(a);
+    auto rb = details::make_unit_range(b);
+    return equal(ra.begin, ra.end, rb.begin, rb.end);
+  }
+};
+
+}  // namespace utf
+}  // namespace nowide
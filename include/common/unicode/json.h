@@ -0,0 +1,287 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file json.h
+ *
+ * @brief Escaping and unescaping of UTF-8 text for JSON and JavaScript string
+ * literals.
+ */
+
+#pragma once
+
+#include <common/unicode/encoding_errors.h>
+#include <common/unicode/swar.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types
+#include <cstring>  // for std::memchr
+#include <iterator>
+#include <string>
+
+namespace nowide {
+
+/// Namespace holding the JSON string escaping functions.
+namespace json {
+
+/// Which characters are escaped by escape().
+enum class escape_mode {
+  /// Only what JSON requires: quotation mark, reverse solidus and control
+  /// characters, plus U+2028 and U+2029 which JavaScript rejects in string
+  /// literals. Other non ASCII text is copied as UTF-8.
+  minimal,
+  /// Everything that minimal escapes, plus every non ASCII character, as
+  /// \\uXXXX escapes (surrogate pairs outside of the BMP). The output is pure
+  /// ASCII.
+  ascii
+};
+
+/// \cond INTERNAL
+namespace details {
+
+///
+/// Does the word contain a byte that cannot be copied as is? Non ASCII bytes
+/// stop the scan in both modes: in minimal mode they still have to be
+/// validated and checked for U+2028 and U+2029.
+///
+inline auto needs_escape(utf::details::word_type w) -> bool {
+  using utf::details::broadcast;
+  using utf::details::equal_bytes;
+  using utf::details::less_bytes;
+  return (less_bytes(w, 0x20) | equal_bytes(w, '"') | equal_bytes(w, '\\') |
+          (w & broadcast(0x80))) != 0;
+}
+
+/// Does the byte \a c stop a verbatim run?
+inline auto is_special(unsigned char c) -> bool {
+  return c < 0x20 || c == '"' || c == '\\' || c >= 0x80;
+}
+
+inline void append_u_escape(std::uint16_t unit, std::string &out) {
+  static const char hex[] = "0123456789abcdef";
+  char buf[6] = {'\\',
+                 'u',
+                 hex[(unit >> 12) & 0xF],
+                 hex[(unit >> 8) & 0xF],
+                 hex[(unit >> 4) & 0xF],
+                 hex[unit & 0xF]};
+  out.append(buf, sizeof(buf));
+}
+
+inline auto hex_value(char c) -> int {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+/// Parse the 4 hex digits of a \\u escape starting at \a p.
+inline auto parse_u_escape(char const *p, char const *end) -> std::uint16_t {
+  if (end - p < 4) {
+    throw conv::conversion_error();
+  }
+  unsigned value = 0;
+  for (int i = 0; i < 4; ++i) {
+    int digit = hex_value(p[i]);
+    if (digit < 0) {
+      throw conv::conversion_error();
+    }
+    value = (value << 4) | static_cast<unsigned>(digit);
+  }
+  return static_cast<std::uint16_t>(value);
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief Append the UTF-8 text [begin, end) to \a out, escaped for use in a
+/// JSON or JavaScript string literal (without the surrounding quotes).
+///
+/// The input is scanned a word at a time for bytes that need attention, and
+/// runs of bytes that do not are copied in bulk. Control characters use the
+/// short escapes (\\n, \\t, ...) when JSON has one.
+///
+/// nowide::conv::conversion_error is thrown if the input is not valid UTF-8.
+///
+inline void escape(char const *begin, char const *end, std::string &out,
+                   escape_mode mode = escape_mode::minimal) {
+  using utf::details::load_word;
+  using utf::details::word_size;
+  out.reserve(out.size() + static_cast<std::size_t>(end - begin));
+  while (begin != end) {
+    // Find the end of the run that can be copied verbatim
+    char const *run = begin;
+    while (static_cast<std::size_t>(end - run) >= word_size &&
+           !details::needs_escape(load_word(run))) {
+      run += word_size;
+    }
+    while (run != end &&
+           !details::is_special(static_cast<unsigned char>(*run))) {
+      ++run;
+    }
+    out.append(begin, run);
+    begin = run;
+    if (begin == end) {
+      break;
+    }
+
+    auto c = static_cast<unsigned char>(*begin);
+    if (c < 0x80) {
+      ++begin;
+      switch (c) {
+        case '"':
+          out.append("\\\"", 2);
+          break;
+        case '\\':
+          out.append("\\\\", 2);
+          break;
+        case '\b':
+          out.append("\\b", 2);
+          break;
+        case '\f':
+          out.append("\\f", 2);
+          break;
+        case '\n':
+          out.append("\\n", 2);
+          break;
+        case '\r':
+          out.append("\\r", 2);
+          break;
+        case '\t':
+          out.append("\\t", 2);
+          break;
+        default:
+          details::append_u_escape(c, out);
+      }
+      continue;
+    }
+
+    char const *start = begin;
+    utf::code_point cp = utf::utf_traits<char>::decode(begin, end);
+    if (cp == utf::illegal || cp == utf::incomplete) {
+      throw conv::conversion_error();
+    }
+    if (mode == escape_mode::ascii || cp == 0x2028 || cp == 0x2029) {
+      std::uint16_t units[2];
+      std::uint16_t *last = utf::utf_traits<char16_t>::encode(cp, units);
+      for (std::uint16_t *unit = units; unit != last; ++unit) {
+        details::append_u_escape(*unit, out);
+      }
+    } else {
+      out.append(start, begin);
+    }
+  }
+}
+
+///
+/// \brief Escape the UTF-8 string \a str for use in a JSON or JavaScript string
+/// literal (without the surrounding quotes).
+///
+/// nowide::conv::conversion_error is thrown if the input is not valid UTF-8.
+///
+inline auto escape(std::string const &str,
+                   escape_mode mode = escape_mode::minimal) -> std::string {
+  std::string result;
+  escape(str.data(), str.data() + str.size(), result, mode);
+  return result;
+}
+
+///
+/// \brief Append the unescaped value of the JSON string literal contents
+/// [begin, end) to \a out, as UTF-8.
+///
+/// Runs of text without a reverse solidus are located with memchr and copied
+/// in bulk; they are not validated. \\uXXXX escapes of a surrogate pair are
+/// combined into a single code point.
+///
+/// nowide::conv::conversion_error is thrown for a malformed escape sequence or
+/// an unpaired surrogate.
+///
+inline void unescape(char const *begin, char const *end, std::string &out) {
+  using traits16 = utf::utf_traits<char16_t>;
+  out.reserve(out.size() + static_cast<std::size_t>(end - begin));
+  std::back_insert_iterator<std::string> inserter(out);
+  while (begin != end) {
+    auto run = static_cast<char const *>(
+        std::memchr(begin, '\\', static_cast<std::size_t>(end - begin)));
+    if (run == nullptr) {
+      out.append(begin, end);
+      break;
+    }
+    out.append(begin, run);
+    begin = run + 1;
+    if (begin == end) {
+      throw conv::conversion_error();
+    }
+    char c = *begin++;
+    switch (c) {
+      case '"':
+      case '\\':
+      case '/':
+        out.push_back(c);
+        break;
+      case 'b':
+        out.push_back('\b');
+        break;
+      case 'f':
+        out.push_back('\f');
+        break;
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'u': {
+        std::uint16_t w1 = details::parse_u_escape(begin, end);
+        begin += 4;
+        utf::code_point cp = w1;
+        if (traits16::is_first_surrogate(w1)) {
+          if (end - begin < 2 || begin[0] != '\\' || begin[1] != 'u') {
+            throw conv::conversion_error();
+          }
+          std::uint16_t w2 = details::parse_u_escape(begin + 2, end);
+          if (!traits16::is_second_surrogate(w2)) {
+            throw conv::conversion_error();
+          }
+          begin += 6;
+          cp = traits16::combine_surrogate(w1, w2);
+        } else if (traits16::is_second_surrogate(w1)) {
+          throw conv::conversion_error();
+        }
+        utf::utf_traits<char>::encode(cp, inserter);
+        break;
+      }
+      default:
+        throw conv::conversion_error();
+    }
+  }
+}
+
+///
+/// \brief Unescape the contents of the JSON string literal \a str, as UTF-8.
+///
+/// nowide::conv::conversion_error is thrown for a malformed escape sequence or
+/// an unpaired surrogate.
+///
+inline auto unescape(std::string const &str) -> std::string {
+  std::string result;
+  unescape(str.data(), str.data() + str.size(), result);
+  return result;
+}
+
+}  // namespace json
+}  // namespace nowide
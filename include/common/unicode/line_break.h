@@ -0,0 +1,545 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file line_break.h
+ *
+ * @brief Line break opportunities in UTF-8 text, following the Unicode line
+ * breaking algorithm (UAX #14).
+ */
+
+#pragma once
+
+#include <common/unicode/utf.h>
+
+#include <algorithm>  // for std::upper_bound
+#include <cstddef>    // for std::size_t
+#include <cstdint>    // for int types
+
+namespace nowide {
+namespace utf {
+
+///
+/// \brief Line breaking classes of UAX #14.
+///
+/// The classes that the algorithm resolves to others before applying its
+/// rules are not represented: AI, SG, XX and SA resolve to al (complex
+/// context dependent scripts, such as Thai, are not broken inside words),
+/// CJ resolves to id and the Hangul classes H2, H3, JL, JV and JT to id.
+///
+enum class line_break_class : std::uint8_t {
+  bk,   ///< Mandatory break
+  cr,   ///< Carriage return
+  lf,   ///< Line feed
+  nl,   ///< Next line
+  sp,   ///< Space
+  zw,   ///< Zero width space
+  zwj,  ///< Zero width joiner
+  cm,   ///< Combining mark
+  wj,   ///< Word joiner
+  gl,   ///< Non-breaking ("glue")
+  cb,   ///< Contingent break opportunity
+  op,   ///< Open punctuation
+  cl,   ///< Close punctuation
+  cp,   ///< Close parenthesis
+  qu,   ///< Quotation
+  ns,   ///< Non-starter
+  ex,   ///< Exclamation / interrogation
+  sy,   ///< Symbols allowing break after
+  is,   ///< Infix numeric separator
+  pr,   ///< Prefix numeric
+  po,   ///< Postfix numeric
+  nu,   ///< Numeric
+  al,   ///< Alphabetic
+  hl,   ///< Hebrew letter
+  id,   ///< Ideographic
+  in,   ///< Inseparable
+  hy,   ///< Hyphen
+  ba,   ///< Break after
+  bb,   ///< Break before
+  b2,   ///< Break opportunity before and after
+  eb,   ///< Emoji base
+  em,   ///< Emoji modifier
+  ri    ///< Regional indicator
+};
+
+/// \cond INTERNAL
+namespace details {
+
+/// Pack the first code point of a run of the class table with its class.
+constexpr auto run(code_point first, line_break_class value) -> std::uint32_t {
+  return (first << 8) | static_cast<std::uint32_t>(value);
+}
+
+inline auto ascii_line_break_class(unsigned char c) -> line_break_class {
+  using lb = line_break_class;
+  static const lb table[128] = {
+      // 0x00
+      lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm,
+      lb::cm, lb::ba, lb::lf, lb::bk, lb::bk, lb::cr, lb::cm, lb::cm,
+      // 0x10
+      lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm,
+      lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm, lb::cm,
+      // 0x20   !       "       #       $       %       &       '
+      lb::sp, lb::ex, lb::qu, lb::al, lb::pr, lb::po, lb::al, lb::qu,
+      // (      )       *       +       ,       -       .       /
+      lb::op, lb::cp, lb::al, lb::pr, lb::is, lb::hy, lb::is, lb::sy,
+      // 0x30
+      lb::nu, lb::nu, lb::nu, lb::nu, lb::nu, lb::nu, lb::nu, lb::nu,
+      // 8      9       :       ;       <       =       >       ?
+      lb::nu, lb::nu, lb::is, lb::is, lb::al, lb::al, lb::al, lb::ex,
+      // 0x40
+      lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al,
+      lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al,
+      // P                                              W
+      lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al,
+      // X      Y       Z       [       \       ]       ^       _
+      lb::al, lb::al, lb::al, lb::op, lb::pr, lb::cp, lb::al, lb::al,
+      // 0x60
+      lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al,
+      lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al,
+      // p                                              w
+      lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al, lb::al,
+      // x      y       z       {       |       }       ~       DEL
+      lb::al, lb::al, lb::al, lb::op, lb::ba, lb::cl, lb::al, lb::cm};
+  return table[c];
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief The line breaking class of the code point \a c.
+///
+/// Code points above U+007F are looked up with a binary search in a table of
+/// runs of code points sharing the same class, each packed in 32 bits. The
+/// table was written by hand from LineBreak.txt, and abridged: it covers the
+/// Latin, Greek, Cyrillic, Hebrew, Arabic, Devanagari and Thai punctuation and
+/// marks, general punctuation, currency symbols, CJK and emoji. Code points it
+/// does not list take the default class, al.
+///
+inline auto line_break_class_of(code_point c) -> line_break_class {
+  if (c < 0x80) {
+    return details::ascii_line_break_class(static_cast<unsigned char>(c));
+  }
+  using lb = line_break_class;
+  using details::run;
+  // Each entry starts a run lasting up to the next entry
+  static const std::uint32_t table[] = {
+      run(0x80, lb::cm), run(0x85, lb::nl), run(0x86, lb::cm),
+      run(0xA0, lb::gl), run(0xA1, lb::op), run(0xA2, lb::po),
+      run(0xA3, lb::pr), run(0xA6, lb::al), run(0xAB, lb::qu),
+      run(0xAC, lb::al), run(0xAD, lb::ba), run(0xAE, lb::al),
+      run(0xB0, lb::po), run(0xB1, lb::pr), run(0xB2, lb::al),
+      run(0xB4, lb::bb), run(0xB5, lb::al), run(0xBB, lb::qu),
+      run(0xBC, lb::al), run(0xBF, lb::op), run(0xC0, lb::al),
+      run(0x2C8, lb::bb), run(0x2C9, lb::al), run(0x2CC, lb::bb),
+      run(0x2CD, lb::al), run(0x2DF, lb::bb), run(0x2E0, lb::al),
+      run(0x300, lb::cm), run(0x34F, lb::gl), run(0x350, lb::cm),
+      run(0x35C, lb::gl), run(0x363, lb::cm), run(0x370, lb::al),
+      run(0x37E, lb::is), run(0x37F, lb::al), run(0x483, lb::cm),
+      run(0x48A, lb::al), run(0x589, lb::is), run(0x58A, lb::ba),
+      run(0x58B, lb::al), run(0x591, lb::cm), run(0x5BE, lb::ba),
+      run(0x5BF, lb::cm), run(0x5C0, lb::al), run(0x5C1, lb::cm),
+      run(0x5C3, lb::al), run(0x5C4, lb::cm), run(0x5C6, lb::al),
+      run(0x5C7, lb::cm), run(0x5C8, lb::al), run(0x5D0, lb::hl),
+      run(0x5EB, lb::al), run(0x5EF, lb::hl), run(0x5F3, lb::al),
+      run(0x609, lb::po), run(0x60C, lb::is), run(0x60E, lb::al),
+      run(0x610, lb::cm), run(0x61B, lb::ex), run(0x61C, lb::al),
+      run(0x61D, lb::ex), run(0x620, lb::al), run(0x64B, lb::cm),
+      run(0x660, lb::nu), run(0x66A, lb::po), run(0x66B, lb::nu),
+      run(0x66D, lb::al), run(0x670, lb::cm), run(0x671, lb::al),
+      run(0x6D4, lb::ex), run(0x6D5, lb::al), run(0x6D6, lb::cm),
+      run(0x6DD, lb::al), run(0x6DF, lb::cm), run(0x6E5, lb::al),
+      run(0x6E7, lb::cm), run(0x6E9, lb::al), run(0x6EA, lb::cm),
+      run(0x6EE, lb::al), run(0x6F0, lb::nu), run(0x6FA, lb::al),
+      run(0x900, lb::cm), run(0x904, lb::al), run(0x93A, lb::cm),
+      run(0x93D, lb::al), run(0x93E, lb::cm), run(0x950, lb::al),
+      run(0x951, lb::cm), run(0x958, lb::al), run(0x962, lb::cm),
+      run(0x964, lb::ba), run(0x966, lb::nu), run(0x970, lb::al),
+      run(0xE31, lb::cm), run(0xE32, lb::al), run(0xE34, lb::cm),
+      run(0xE3B, lb::al), run(0xE47, lb::cm), run(0xE4F, lb::al),
+      run(0xE50, lb::nu), run(0xE5A, lb::ba), run(0xE5C, lb::al),
+      run(0xF0B, lb::ba), run(0xF0C, lb::gl), run(0xF0D, lb::al),
+      run(0x1100, lb::id), run(0x1200, lb::al), run(0x1680, lb::ba),
+      run(0x1681, lb::al), run(0x17D4, lb::ba), run(0x17D6, lb::al),
+      run(0x180E, lb::gl), run(0x180F, lb::al), run(0x1AB0, lb::cm),
+      run(0x1B00, lb::al), run(0x1DC0, lb::cm), run(0x1E00, lb::al),
+      run(0x2000, lb::ba), run(0x2007, lb::gl), run(0x2008, lb::ba),
+      run(0x200B, lb::zw), run(0x200C, lb::cm), run(0x200D, lb::zwj),
+      run(0x200E, lb::cm), run(0x2010, lb::ba), run(0x2011, lb::gl),
+      run(0x2012, lb::ba), run(0x2014, lb::b2), run(0x2015, lb::al),
+      run(0x2018, lb::qu), run(0x201A, lb::op), run(0x201B, lb::qu),
+      run(0x201E, lb::op), run(0x201F, lb::qu), run(0x2020, lb::al),
+      run(0x2024, lb::in), run(0x2027, lb::ba), run(0x2028, lb::bk),
+      run(0x202A, lb::cm), run(0x202F, lb::gl), run(0x2030, lb::po),
+      run(0x2038, lb::al), run(0x2039, lb::qu), run(0x203B, lb::al),
+      run(0x203C, lb::ns), run(0x203E, lb::al), run(0x2044, lb::is),
+      run(0x2045, lb::op), run(0x2046, lb::cl), run(0x2047, lb::ns),
+      run(0x204A, lb::al), run(0x2056, lb::ba), run(0x2057, lb::al),
+      run(0x2058, lb::ba), run(0x205C, lb::al), run(0x205D, lb::ba),
+      run(0x2060, lb::wj), run(0x2061, lb::al), run(0x2066, lb::cm),
+      run(0x2070, lb::al), run(0x207D, lb::op), run(0x207E, lb::cl),
+      run(0x207F, lb::al), run(0x208D, lb::op), run(0x208E, lb::cl),
+      run(0x208F, lb::al), run(0x20A0, lb::pr), run(0x20A7, lb::po),
+      run(0x20A8, lb::pr), run(0x20B6, lb::po), run(0x20B7, lb::pr),
+      run(0x20BB, lb::po), run(0x20BC, lb::pr), run(0x20BE, lb::po),
+      run(0x20BF, lb::pr), run(0x20D0, lb::cm), run(0x20F1, lb::al),
+      run(0x2103, lb::po), run(0x2104, lb::al), run(0x2109, lb::po),
+      run(0x210A, lb::al), run(0x2116, lb::pr), run(0x2117, lb::al),
+      run(0x2212, lb::pr), run(0x2214, lb::al), run(0x2308, lb::op),
+      run(0x2309, lb::cl), run(0x230A, lb::op), run(0x230B, lb::cl),
+      run(0x230C, lb::al), run(0x2329, lb::op), run(0x232A, lb::cl),
+      run(0x232B, lb::al), run(0x261D, lb::eb), run(0x261E, lb::al),
+      run(0x26F9, lb::eb), run(0x26FA, lb::al), run(0x270A, lb::eb),
+      run(0x270E, lb::al), run(0x2E80, lb::id), run(0x3000, lb::ba),
+      run(0x3001, lb::cl), run(0x3003, lb::id), run(0x3005, lb::ns),
+      run(0x3006, lb::id), run(0x3008, lb::op), run(0x3009, lb::cl),
+      run(0x300A, lb::op), run(0x300B, lb::cl), run(0x300C, lb::op),
+      run(0x300D, lb::cl), run(0x300E, lb::op), run(0x300F, lb::cl),
+      run(0x3010, lb::op), run(0x3011, lb::cl), run(0x3012, lb::id),
+      run(0x3014, lb::op), run(0x3015, lb::cl), run(0x3016, lb::op),
+      run(0x3017, lb::cl), run(0x3018, lb::op), run(0x3019, lb::cl),
+      run(0x301A, lb::op), run(0x301B, lb::cl), run(0x301C, lb::ns),
+      run(0x301D, lb::op), run(0x301E, lb::cl), run(0x3020, lb::id),
+      run(0x302A, lb::cm), run(0x3030, lb::id), run(0x303B, lb::ns),
+      run(0x303D, lb::id), run(0x3099, lb::cm), run(0x309B, lb::ns),
+      run(0x309F, lb::id), run(0x30A0, lb::ns), run(0x30A1, lb::id),
+      run(0x30FB, lb::ns), run(0x30FF, lb::id), run(0x4DC0, lb::al),
+      run(0x4E00, lb::id), run(0xA4D0, lb::al), run(0xAC00, lb::id),
+      run(0xD7A4, lb::al), run(0xF900, lb::id), run(0xFB00, lb::al),
+      run(0xFB1D, lb::hl), run(0xFB1E, lb::cm), run(0xFB1F, lb::hl),
+      run(0xFB50, lb::al), run(0xFD3E, lb::cl), run(0xFD3F, lb::op),
+      run(0xFD40, lb::al), run(0xFE00, lb::cm), run(0xFE10, lb::is),
+      run(0xFE11, lb::cl), run(0xFE13, lb::is), run(0xFE15, lb::ex),
+      run(0xFE17, lb::op), run(0xFE18, lb::cl), run(0xFE19, lb::in),
+      run(0xFE1A, lb::al), run(0xFE20, lb::cm), run(0xFE30, lb::id),
+      run(0xFE50, lb::cl), run(0xFE51, lb::id), run(0xFE52, lb::cl),
+      run(0xFE53, lb::al), run(0xFE54, lb::ns), run(0xFE56, lb::ex),
+      run(0xFE58, lb::id), run(0xFE59, lb::op), run(0xFE5A, lb::cl),
+      run(0xFE5B, lb::op), run(0xFE5C, lb::cl), run(0xFE5D, lb::op),
+      run(0xFE5E, lb::cl), run(0xFE5F, lb::id), run(0xFE67, lb::al),
+      run(0xFE68, lb::id), run(0xFE69, lb::pr), run(0xFE6A, lb::po),
+      run(0xFE6B, lb::id), run(0xFE6C, lb::al), run(0xFEFF, lb::wj),
+      run(0xFF00, lb::al), run(0xFF01, lb::ex), run(0xFF02, lb::id),
+      run(0xFF04, lb::pr), run(0xFF05, lb::po), run(0xFF06, lb::id),
+      run(0xFF08, lb::op), run(0xFF09, lb::cl), run(0xFF0A, lb::id),
+      run(0xFF0C, lb::cl), run(0xFF0D, lb::id), run(0xFF0E, lb::cl),
+      run(0xFF0F, lb::id), run(0xFF1A, lb::ns), run(0xFF1C, lb::id),
+      run(0xFF1F, lb::ex), run(0xFF20, lb::id), run(0xFF3B, lb::op),
+      run(0xFF3C, lb::id), run(0xFF3D, lb::cl), run(0xFF3E, lb::id),
+      run(0xFF5B, lb::op), run(0xFF5C, lb::id), run(0xFF5D, lb::cl),
+      run(0xFF5E, lb::id), run(0xFF5F, lb::op), run(0xFF60, lb::cl),
+      run(0xFF62, lb::op), run(0xFF63, lb::cl), run(0xFF65, lb::ns),
+      run(0xFF66, lb::al), run(0xFF9E, lb::ns), run(0xFFA0, lb::al),
+      run(0xFFE0, lb::po), run(0xFFE1, lb::pr), run(0xFFE2, lb::id),
+      run(0xFFE5, lb::pr), run(0xFFE7, lb::al), run(0xFFF9, lb::cm),
+      run(0xFFFC, lb::cb), run(0xFFFD, lb::al), run(0x1F000, lb::id),
+      run(0x1F100, lb::al), run(0x1F1E6, lb::ri), run(0x1F200, lb::id),
+      run(0x1F385, lb::eb), run(0x1F386, lb::id), run(0x1F3C2, lb::eb),
+      run(0x1F3C5, lb::id), run(0x1F3C7, lb::eb), run(0x1F3C8, lb::id),
+      run(0x1F3CA, lb::eb), run(0x1F3CD, lb::id), run(0x1F3FB, lb::em),
+      run(0x1F400, lb::id), run(0x1F442, lb::eb), run(0x1F444, lb::id),
+      run(0x1F446, lb::eb), run(0x1F451, lb::id), run(0x1F466, lb::eb),
+      run(0x1F479, lb::id), run(0x1F47C, lb::eb), run(0x1F47D, lb::id),
+      run(0x1F481, lb::eb), run(0x1F484, lb::id), run(0x1F485, lb::eb),
+      run(0x1F488, lb::id), run(0x1F4AA, lb::eb), run(0x1F4AB, lb::id),
+      run(0x1F574, lb::eb), run(0x1F576, lb::id), run(0x1F57A, lb::eb),
+      run(0x1F57B, lb::id), run(0x1F590, lb::eb), run(0x1F591, lb::id),
+      run(0x1F595, lb::eb), run(0x1F597, lb::id), run(0x1F645, lb::eb),
+      run(0x1F648, lb::id), run(0x1F64B, lb::eb), run(0x1F650, lb::id),
+      run(0x1F6A3, lb::eb), run(0x1F6A4, lb::id), run(0x1F6B4, lb::eb),
+      run(0x1F6B7, lb::id), run(0x1F6C0, lb::eb), run(0x1F6C1, lb::id),
+      run(0x1F6CC, lb::eb), run(0x1F6CD, lb::id), run(0x1F918, lb::eb),
+      run(0x1F920, lb::id), run(0x1F926, lb::eb), run(0x1F927, lb::id),
+      run(0x1F930, lb::eb), run(0x1F93A, lb::id), run(0x1F93D, lb::eb),
+      run(0x1F93F, lb::id), run(0x1F9D1, lb::eb), run(0x1F9DE, lb::id),
+      run(0x1FB00, lb::al), run(0x1FC00, lb::id), run(0x1FFFE, lb::al),
+      run(0x20000, lb::id), run(0x3FFFE, lb::al), run(0xE0001, lb::cm),
+      run(0xE0002, lb::al), run(0xE0020, lb::cm), run(0xE0080, lb::al),
+      run(0xE0100, lb::cm), run(0xE01F0, lb::al)};
+  static const std::uint32_t *const table_end =
+      table + sizeof(table) / sizeof(table[0]);
+  if (c > 0x10FFFF) {
+    return lb::al;
+  }
+  const std::uint32_t *next =
+      std::upper_bound(table, table_end, (c << 8) | 0xFF);
+  return static_cast<line_break_class>(next[-1] & 0xFF);
+}
+
+///
+/// \brief Iterator over the line break opportunities of UTF-8 text.
+///
+/// The text is decoded on the fly with utf_traits<char>::decode(), with no
+/// allocation; ASCII characters are classified with a direct table lookup
+/// and runs of letters and digits, which never break, are skipped without
+/// going through the rules. Ill-formed sequences are treated as U+FFFD.
+///
+/// The rules are those of UAX #14 with the following simplifications: the
+/// number rule (LB25) uses the pair based approximation of the example
+/// implementation of UAX #14, the rules that depend on the East Asian width
+/// are not tailored, and classes are resolved as described for
+/// line_break_class.
+///
+/// \code
+/// nowide::utf::line_break_iterator breaks(text.data(), text.data() +
+///                                         text.size());
+/// while (breaks.next()) {
+///   // A line can end before breaks.position(), and must end there if
+///   // breaks.mandatory()
+/// }
+/// \endcode
+///
+class line_break_iterator {
+ public:
+  /// Iterate over the break opportunities of the UTF-8 text [begin, end).
+  line_break_iterator(char const *begin, char const *end)
+      : p_(begin), end_(end) {}
+
+  ///
+  /// \brief Find the next break opportunity.
+  ///
+  /// Returns false when there are no more. The end of a non-empty text is
+  /// always a (mandatory) break opportunity.
+  ///
+  auto next() -> bool {
+    if (p_ == end_) {
+      if (done_ || !started_) {
+        return false;
+      }
+      done_ = true;
+      position_ = end_;
+      mandatory_ = true;
+      return true;
+    }
+    if (!started_) {
+      // LB2: no break at the start of the text
+      started_ = true;
+      line_break_class c = decode_class();
+      after_zwj_ = c == line_break_class::zwj;
+      advance(is_mark(c) ? line_break_class::al : c);
+    }
+    while (p_ != end_) {
+      char const *start = p_;
+      // Fast path: letters and digits after a letter or a digit
+      if ((last_ == line_break_class::al || last_ == line_break_class::nu) &&
+          !after_zwj_) {
+        while (p_ != end_ && is_alnum(*p_)) {
+          last_ = *p_ <= '9' ? line_break_class::nu : line_break_class::al;
+          ++p_;
+        }
+        in_number_ = last_ == line_break_class::nu;
+        if (p_ == end_) {
+          break;
+        }
+        start = p_;
+      }
+      line_break_class c = decode_class();
+      if (is_mark(c) && !is_break_or_space(last_)) {
+        // LB9: marks take the class of the character they follow
+        after_zwj_ = c == line_break_class::zwj;
+        continue;
+      }
+      // LB10: other marks are alphabetic
+      line_break_class b = is_mark(c) ? line_break_class::al : c;
+      bool found = check_break(b, start);
+      after_zwj_ = c == line_break_class::zwj;
+      advance(b);
+      if (found) {
+        return true;
+      }
+    }
+    return next();
+  }
+
+  /// The position of the last break opportunity found: a line can end just
+  /// before it.
+  auto position() const -> char const * { return position_; }
+
+  /// Whether a line must end at the last break opportunity found: after a
+  /// line terminator or at the end of the text.
+  auto mandatory() const -> bool { return mandatory_; }
+
+ private:
+  enum class decision { none, allowed, mandatory };
+
+  static auto is_alnum(char c) -> bool {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9');
+  }
+
+  static auto is_mark(line_break_class c) -> bool {
+    return c == line_break_class::cm || c == line_break_class::zwj;
+  }
+
+  static auto is_break_or_space(line_break_class c) -> bool {
+    return c <= line_break_class::zw;
+  }
+
+  static auto is_letter(line_break_class c) -> bool {
+    return c == line_break_class::al || c == line_break_class::hl;
+  }
+
+  auto decode_class() -> line_break_class {
+    auto lead = static_cast<unsigned char>(*p_);
+    if (lead < 0x80) {
+      ++p_;
+      return details::ascii_line_break_class(lead);
+    }
+    code_point c = utf_traits<char>::decode(p_, end_);
+    if (c == illegal || c == incomplete) {
+      return line_break_class::al;
+    }
+    return line_break_class_of(c);
+  }
+
+  /// Apply the rules to a break between the current state and a character
+  /// of class \a b starting at \a start; record the break if there is one.
+  auto check_break(line_break_class b, char const *start) -> bool {
+    decision d = decide(b);
+    if (d == decision::none) {
+      return false;
+    }
+    position_ = start;
+    mandatory_ = d == decision::mandatory;
+    return true;
+  }
+
+  auto decide(line_break_class b) const -> decision {
+    using lb = line_break_class;
+    const lb a = last_;
+    // LB4, LB5
+    if (a == lb::bk || a == lb::lf || a == lb::nl) {
+      return decision::mandatory;
+    }
+    if (a == lb::cr) {
+      return b == lb::lf ? decision::none : decision::mandatory;
+    }
+    // LB6, LB7
+    if (is_break_or_space(b)) {
+      return decision::none;
+    }
+    // The class before a run of spaces, for the rules that skip them
+    const lb s = a == lb::sp ? before_space_ : a;
+    // LB8, LB8a
+    if (s == lb::zw) {
+      return decision::allowed;
+    }
+    if (after_zwj_) {
+      return decision::none;
+    }
+    // LB11, LB12, LB12a
+    if (a == lb::wj || b == lb::wj || a == lb::gl) {
+      return decision::none;
+    }
+    if (b == lb::gl && a != lb::sp && a != lb::ba && a != lb::hy) {
+      return decision::none;
+    }
+    // LB13
+    if (b == lb::cl || b == lb::cp || b == lb::ex || b == lb::is ||
+        b == lb::sy) {
+      return decision::none;
+    }
+    // LB14, LB15, LB16, LB17
+    if (s == lb::op || (s == lb::qu && b == lb::op) ||
+        ((s == lb::cl || s == lb::cp) && b == lb::ns) ||
+        (s == lb::b2 && b == lb::b2)) {
+      return decision::none;
+    }
+    // LB18
+    if (a == lb::sp) {
+      return decision::allowed;
+    }
+    // LB19, LB20
+    if (a == lb::qu || b == lb::qu) {
+      return decision::none;
+    }
+    if (a == lb::cb || b == lb::cb) {
+      return decision::allowed;
+    }
+    // LB21, LB21a, LB21b, LB22
+    if (b == lb::ba || b == lb::hy || b == lb::ns || a == lb::bb ||
+        hebrew_hyphen_ || (a == lb::sy && b == lb::hl) || b == lb::in) {
+      return decision::none;
+    }
+    // LB23, LB23a, LB24
+    if ((is_letter(a) && (b == lb::nu || b == lb::pr || b == lb::po)) ||
+        (a == lb::nu && is_letter(b)) ||
+        ((a == lb::pr || a == lb::po) && is_letter(b)) ||
+        (a == lb::pr && (b == lb::id || b == lb::eb || b == lb::em)) ||
+        ((a == lb::id || a == lb::eb || a == lb::em) && b == lb::po)) {
+      return decision::none;
+    }
+    // LB25
+    if (b == lb::nu && (a == lb::pr || a == lb::po || a == lb::op ||
+                        a == lb::hy || in_number_)) {
+      return decision::none;
+    }
+    if (in_number_ && (b == lb::po || b == lb::pr)) {
+      return decision::none;
+    }
+    if ((a == lb::pr || a == lb::po) && (b == lb::op || b == lb::hy)) {
+      return decision::none;
+    }
+    // LB28, LB29, LB30
+    if ((is_letter(a) || a == lb::is) && is_letter(b)) {
+      return decision::none;
+    }
+    if ((is_letter(a) || a == lb::nu) && b == lb::op) {
+      return decision::none;
+    }
+    if (a == lb::cp && (is_letter(b) || b == lb::nu)) {
+      return decision::none;
+    }
+    // LB30a, LB30b
+    if ((a == lb::ri && b == lb::ri && ri_count_ % 2 == 1) ||
+        (a == lb::eb && b == lb::em)) {
+      return decision::none;
+    }
+    // LB31
+    return decision::allowed;
+  }
+
+  /// Update the state with a character of class \a b.
+  void advance(line_break_class b) {
+    using lb = line_break_class;
+    hebrew_hyphen_ = (b == lb::hy || b == lb::ba) && last_ == lb::hl;
+    if (b == lb::nu) {
+      in_number_ = true;
+    } else if (b != lb::sy && b != lb::is && b != lb::cl && b != lb::cp) {
+      in_number_ = false;
+    }
+    ri_count_ = b == lb::ri ? ri_count_ + 1 : 0;
+    if (b == lb::sp) {
+      if (last_ != lb::sp) {
+        before_space_ = last_;
+      }
+    }
+    last_ = b;
+  }
+
+  char const *p_;
+  char const *end_;
+  char const *position_{nullptr};
+  bool mandatory_{false};
+  bool started_{false};
+  bool done_{false};
+  /// Class of the last character, after LB9 and LB10
+  line_break_class last_{line_break_class::al};
+  /// Class of the character before the current run of spaces
+  line_break_class before_space_{line_break_class::al};
+  /// The last character is a ZWJ (LB8a)
+  bool after_zwj_{false};
+  /// The last character is a hyphen after a Hebrew letter (LB21a)
+  bool hebrew_hyphen_{false};
+  /// The last characters are NU (NU | SY | IS)* (CL | CP)? (LB25)
+  bool in_number_{false};
+  /// Number of regional indicators in a row (LB30a)
+  unsigned ri_count_{0};
+};
+
+}  // namespace utf
+}  // namespace nowide
@@ -0,0 +1,217 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file streambuf.h
+ *
+ * @brief A stream buffer transcoding between two Unicode encodings on the fly,
+ * on top of another stream buffer.
+ */
+
+#pragma once
+
+#include <common/unicode/encoding_errors.h>
+#include <common/unicode/encoding_utf.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstring>  // for std::memmove
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace nowide {
+
+///
+/// \brief Stream buffer of \a CharIn presenting a stream buffer of \a CharOut,
+/// the "device", in another Unicode encoding.
+///
+/// Text written to it is converted to the encoding of \a CharOut and written
+/// to the device; text read from it is read from the device and converted to
+/// the encoding of \a CharIn. For example, a std::wostream on top of a
+/// transcoding_streambuf writes UTF-8 to a file opened as a narrow
+/// std::filebuf, without ever holding the whole text in memory:
+///
+/// \code
+/// std::filebuf file;
+/// file.open("out.txt", std::ios_base::out | std::ios_base::binary);
+/// nowide::transcoding_streambuf buf(&file);
+/// std::wostream out(&buf);
+/// out << L"hello \u05e9\u05dc\u05d5\u05dd" << std::endl;
+/// \endcode
+///
+/// The conversion works in fixed size blocks of block_size code units, in
+/// both directions. A sequence split over two blocks, or over two writes, is
+/// carried over to the next block. Text written is only converted and passed
+/// on to the device when the block is full or the stream is flushed; the
+/// device itself is flushed by pubsync().
+///
+/// An ill-formed sequence makes the operation that meets it throw
+/// nowide::conv::conversion_error, which the iostreams turn into badbit (and
+/// rethrow if asked to with exceptions()). The text before the error is
+/// converted as usual. An incomplete sequence at the end of the device is an
+/// error too; an incomplete sequence still pending when the buffer is
+/// destroyed is dropped.
+///
+/// Positioning is not supported.
+///
+template <typename CharOut, typename CharIn,
+          typename TraitsOut = std::char_traits<CharOut>,
+          typename TraitsIn = std::char_traits<CharIn>>
+class basic_transcoding_streambuf
+    : public std::basic_streambuf<CharIn, TraitsIn> {
+ public:
+  /// The type of the wrapped stream buffer.
+  using device_type = std::basic_streambuf<CharOut, TraitsOut>;
+  using int_type = typename TraitsIn::int_type;
+
+  /// Number of code units converted at once, in each direction.
+  static const std::size_t block_size = 4096;
+
+  /// Transcode to and from \a device, which must outlive this buffer.
+  explicit basic_transcoding_streambuf(device_type *device)
+      : device_(device),
+        put_(block_size),
+        get_(conv::details::max_output_units<CharIn, CharOut>(raw_size)),
+        read_(raw_size),
+        write_(put_out_size) {
+    this->setp(put_.data(), put_.data() + put_.size());
+    this->setg(get_.data(), get_.data(), get_.data());
+  }
+
+  basic_transcoding_streambuf(const basic_transcoding_streambuf &) = delete;
+  auto operator=(const basic_transcoding_streambuf &)
+      -> basic_transcoding_streambuf & = delete;
+
+  /// Convert and write what is left in the put area, without flushing the
+  /// device.
+  ~basic_transcoding_streambuf() override {
+    try {
+      flush_put();
+    } catch (...) {
+      // Destructors do not throw; the remaining text is lost
+    }
+  }
+
+ protected:
+  auto overflow(int_type c) -> int_type override {
+    if (!flush_put()) {
+      return TraitsIn::eof();
+    }
+    if (TraitsIn::eq_int_type(c, TraitsIn::eof())) {
+      return TraitsIn::not_eof(c);
+    }
+    *this->pptr() = TraitsIn::to_char_type(c);
+    this->pbump(1);
+    return c;
+  }
+
+  auto sync() -> int override {
+    if (!flush_put()) {
+      return -1;
+    }
+    return device_->pubsync();
+  }
+
+  auto underflow() -> int_type override {
+    if (this->gptr() < this->egptr()) {
+      return TraitsIn::to_int_type(*this->gptr());
+    }
+    CharOut *const raw = read_.data();
+    for (;;) {
+      auto wanted = static_cast<std::streamsize>(raw_size - carry_);
+      std::streamsize got = device_->sgetn(raw + carry_, wanted);
+      std::size_t total = carry_ + static_cast<std::size_t>(got);
+      CharOut const *begin = raw;
+      CharOut const *end = raw + total;
+      CharIn *const first = get_.data();
+      CharIn *out = conv::details::convert_units(begin, end, end, first);
+      carry_ = static_cast<std::size_t>(end - begin);
+      if (carry_ != 0) {
+        // Keep the rest for the next call, which reports the error if it is
+        // an ill-formed sequence or the end of the device
+        bool at_end = got < wanted;
+        if (out == first && (at_end || !is_incomplete(begin, end))) {
+          carry_ = 0;
+          throw conv::conversion_error();
+        }
+        std::memmove(raw, begin, carry_ * sizeof(CharOut));
+      }
+      this->setg(first, first, out);
+      if (out != first) {
+        return TraitsIn::to_int_type(*first);
+      }
+      if (got == 0) {
+        return TraitsIn::eof();
+      }
+    }
+  }
+
+ private:
+  /// Worst case number of device code units of a converted put area.
+  static const std::size_t put_out_size =
+      conv::details::max_output_units<CharOut, CharIn>(
+          block_size + utf::utf_traits<CharIn>::max_width);
+  /// Number of device code units read at once, including the carry.
+  static const std::size_t raw_size =
+      block_size + utf::utf_traits<CharOut>::max_width;
+
+  template <typename CharType>
+  static auto is_incomplete(CharType const *begin, CharType const *end)
+      -> bool {
+    return utf::utf_traits<CharType>::template decode<CharType const *>(
+               begin, end) == utf::incomplete;
+  }
+
+  /// Convert and write the complete sequences of the put area, and move the
+  /// incomplete one at its end, if any, to its beginning.
+  auto flush_put() -> bool {
+    CharIn const *begin = this->pbase();
+    CharIn const *end = this->pptr();
+    if (begin == end) {
+      return true;
+    }
+    CharOut *const first = write_.data();
+    CharOut *out = conv::details::convert_units(begin, end, end, first);
+    auto count = static_cast<std::streamsize>(out - first);
+    if (device_->sputn(first, count) != count) {
+      return false;
+    }
+    auto carry = static_cast<std::size_t>(end - begin);
+    if (carry != 0 && !is_incomplete(begin, end)) {
+      this->setp(put_.data(), put_.data() + put_.size());
+      throw conv::conversion_error();
+    }
+    std::memmove(put_.data(), begin, carry * sizeof(CharIn));
+    this->setp(put_.data(), put_.data() + put_.size());
+    this->pbump(static_cast<int>(carry));
+    return true;
+  }
+
+  device_type *device_;
+  /// Put area, in the encoding of CharIn
+  std::vector<CharIn> put_;
+  /// Get area, in the encoding of CharIn
+  std::vector<CharIn> get_;
+  /// Code units read from the device
+  std::vector<CharOut> read_;
+  /// Code units to write to the device
+  std::vector<CharOut> write_;
+  /// Number of code units at the start of read_ not converted yet
+  std::size_t carry_{0};
+};
+
+template <typename CharOut, typename CharIn, typename TraitsOut,
+          typename TraitsIn>
+const std::size_t basic_transcoding_streambuf<CharOut, CharIn, TraitsOut,
+                                              TraitsIn>::block_size;
+
+///
+/// \brief Wide text stream buffer over a narrow UTF-8 device, e.g. to use a
+/// std::wostream on a std::filebuf.
+///
+using transcoding_streambuf = basic_transcoding_streambuf<char, wchar_t>;
+
+}  // namespace nowide
@@ -0,0 +1,220 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file swar.h
+ *
+ * @brief Word-at-a-time ("SIMD within a register") scanning primitives used by
+ * the bulk paths of the unicode module.
+ *
+ * Everything here is internal. The helpers work on 64-bit words loaded with
+ * `memcpy`, which compilers turn into single unaligned loads, and they do not
+ * depend on any instruction set extension. Loops written on top of them are
+ * also simple enough for the auto-vectorizer to widen further.
+ */
+
+#pragma once
+
+#include <hedley/hedley.h>
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for int types, std::uintptr_t
+#include <cstring>  // for std::memcpy, strnlen
+#include <cwchar>   // for wcsnlen
+#include <type_traits>
+
+namespace nowide {
+namespace utf {
+
+/// \cond INTERNAL
+#if defined(__GNUC__) || defined(__clang__)
+#define NOWIDE_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#define NOWIDE_MAY_ALIAS __attribute__((__may_alias__))
+#else
+#define NOWIDE_NO_SANITIZE_ADDRESS
+#define NOWIDE_MAY_ALIAS
+#endif
+
+namespace details {
+
+/// The machine word used for block scanning.
+using word_type = std::uint64_t;
+
+/// Number of bytes processed per block.
+static const std::size_t word_size = sizeof(word_type);
+
+/// A word type that may alias any other type, for direct aligned loads.
+typedef word_type aliasing_word_type NOWIDE_MAY_ALIAS;
+
+/// Load a word from a possibly unaligned address.
+inline auto load_word(void const *p) -> word_type {
+  word_type w;
+  std::memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+/// Repeat the byte \a b in every byte of a word.
+constexpr auto broadcast(unsigned char b) -> word_type {
+  return static_cast<word_type>(0x0101010101010101ULL) * b;
+}
+
+/// Exact mask with the high bit set in every byte of \a w that is zero.
+inline auto zero_bytes(word_type w) -> word_type {
+  const word_type low7 = broadcast(0x7F);
+  return ~(((w & low7) + low7) | w | low7);
+}
+
+/// Mask with the high bit set in every byte of \a w that is equal to \a b.
+inline auto equal_bytes(word_type w, unsigned char b) -> word_type {
+  return zero_bytes(w ^ broadcast(b));
+}
+
+///
+/// Non-zero if some byte of \a w is less than \a n, which must be at most
+/// 128. Bytes above the first match may be reported too, so the result is
+/// only good for testing whether the word needs a closer look.
+///
+inline auto less_bytes(word_type w, unsigned char n) -> word_type {
+  return (w - broadcast(n)) & ~w & broadcast(0x80);
+}
+
+/// Number of bits set in \a w.
+inline auto popcount(word_type w) -> int {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(w);
+#else
+  int count = 0;
+  for (; w != 0; w &= w - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+/// Mask with the high bit set in every byte whose offset in memory is
+/// congruent to \a offset modulo \a stride. Building the mask from a byte
+/// pattern keeps it independent of the host byte order.
+inline auto offset_mask(std::size_t stride, std::size_t offset) -> word_type {
+  unsigned char bytes[word_size];
+  for (std::size_t i = 0; i < word_size; ++i) {
+    bytes[i] = (i % stride == offset) ? 0x80 : 0x00;
+  }
+  return load_word(bytes);
+}
+
+/// Per code unit width, the bits that are all clear for an ASCII code unit.
+template <std::size_t size>
+struct non_ascii_mask;
+template <>
+struct non_ascii_mask<1> {
+  static constexpr word_type value = 0x8080808080808080ULL;
+};
+template <>
+struct non_ascii_mask<2> {
+  static constexpr word_type value = 0xFF80FF80FF80FF80ULL;
+};
+template <>
+struct non_ascii_mask<4> {
+  static constexpr word_type value = 0xFFFFFF80FFFFFF80ULL;
+};
+
+/// Per code unit width, the bits of the lowest bit of each code unit.
+template <std::size_t size>
+struct low_unit_bits;
+template <>
+struct low_unit_bits<1> {
+  static constexpr word_type value = 0x0101010101010101ULL;
+};
+template <>
+struct low_unit_bits<2> {
+  static constexpr word_type value = 0x0001000100010001ULL;
+};
+template <>
+struct low_unit_bits<4> {
+  static constexpr word_type value = 0x0000000100000001ULL;
+};
+
+///
+/// Load the aligned word at \a p, which may extend past the end of the object
+/// holding the NUL terminated string being scanned. An aligned word never
+/// crosses a page boundary so the read itself is safe, but address sanitizer
+/// would still report it.
+///
+NOWIDE_NO_SANITIZE_ADDRESS inline auto load_aligned_word(void const *p)
+    -> word_type {
+  return *static_cast<aliasing_word_type const *>(p);
+}
+
+///
+/// Returns the terminator of the NUL terminated string at \a p if it is one of
+/// the first \a max code units, or \a p + \a max otherwise.
+///
+/// Once \a p is aligned, a whole word is tested for a zero code unit at once.
+/// Nothing past the aligned word holding the terminator is ever read.
+///
+template <typename CharType>
+auto find_terminator(CharType const *p, std::size_t max) -> CharType const * {
+  static const std::size_t units = word_size / sizeof(CharType);
+  for (; max > 0 && reinterpret_cast<std::uintptr_t>(p) % word_size != 0;
+       ++p, --max) {
+    if (*p == 0) {
+      return p;
+    }
+  }
+  const word_type low = low_unit_bits<sizeof(CharType)>::value;
+  const word_type high = low << (8 * sizeof(CharType) - 1);
+  for (; max >= units; p += units, max -= units) {
+    word_type w = load_aligned_word(p);
+    if (((w - low) & ~w & high) != 0) {
+      break;
+    }
+  }
+  for (; max > 0; ++p, --max) {
+    if (*p == 0) {
+      return p;
+    }
+  }
+  return p;
+}
+
+// The C libraries have vectorized versions for char and wchar_t, which never
+// look past the terminator either.
+inline auto find_terminator(char const *p, std::size_t max) -> char const * {
+  return p + ::strnlen(p, max);
+}
+
+inline auto find_terminator(wchar_t const *p, std::size_t max)
+    -> wchar_t const * {
+  return p + ::wcsnlen(p, max);
+}
+
+///
+/// Returns the first code unit in [begin, end) that is not ASCII, or \a end.
+///
+template <typename CharType>
+auto ascii_prefix(CharType const *begin, CharType const *end)
+    -> CharType const * {
+  static const std::size_t units = word_size / sizeof(CharType);
+  const word_type mask = non_ascii_mask<sizeof(CharType)>::value;
+  while (static_cast<std::size_t>(end - begin) >= 2 * units) {
+    word_type w = load_word(begin) | load_word(begin + units);
+    if ((w & mask) != 0) {
+      break;
+    }
+    begin += 2 * units;
+  }
+  while (begin != end &&
+         static_cast<std::uint32_t>(static_cast<
+             typename std::make_unsigned<CharType>::type>(*begin)) < 0x80) {
+    ++begin;
+  }
+  return begin;
+}
+
+}  // namespace details
+/// \endcond
+
+}  // namespace utf
+}  // namespace nowide
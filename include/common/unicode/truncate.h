@@ -0,0 +1,205 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+/*!
+ * @file truncate.h
+ *
+ * @brief Truncation of Unicode text to a budget of code units without cutting
+ * a character in half.
+ */
+
+#pragma once
+
+#include <common/unicode/line_break.h>
+#include <common/unicode/utf.h>
+
+#include <cstddef>  // for std::size_t
+#include <string>
+
+namespace nowide {
+namespace utf {
+
+/// Where truncate() may cut the text.
+enum class truncate_mode {
+  /// Between two code points
+  whole_code_point,
+  /// Between two user perceived characters: a base character is kept with
+  /// its combining marks, emoji modifiers and zero width joiner sequences,
+  /// regional indicators are kept in pairs, and CR LF is kept together.
+  grapheme
+};
+
+/// \cond INTERNAL
+namespace details {
+
+/// The start of the code point ending at \a p, which must be after \a begin.
+template <typename CharType>
+auto previous_code_point(CharType const *begin, CharType const *p)
+    -> CharType const * {
+  CharType const *q = p - 1;
+  for (std::size_t i = 1; i < utf_traits<CharType>::max_width && q != begin &&
+                          utf_traits<CharType>::is_trail(*q);
+       ++i) {
+    --q;
+  }
+  return q;
+}
+
+/// The code point starting at \a p, or illegal.
+template <typename CharType>
+auto code_point_at(CharType const *p, CharType const *end) -> code_point {
+  return utf_traits<CharType>::template decode<CharType const *>(p, end);
+}
+
+/// Does \a c attach to the character before it (grapheme Extend, ZWJ and
+/// SpacingMark, approximated with the line breaking classes)?
+inline auto is_grapheme_extend(code_point c) -> bool {
+  if (c < 0xA0) {
+    // Controls are line breaking combining marks, but graphemes of their own
+    return false;
+  }
+  line_break_class lb = line_break_class_of(c);
+  return lb == line_break_class::cm || lb == line_break_class::zwj ||
+         lb == line_break_class::em;
+}
+
+inline auto is_hangul_jamo_vt(code_point c) -> bool {
+  return c >= 0x1160 && c <= 0x11FF;
+}
+
+inline auto is_hangul_leading(code_point c) -> bool {
+  return (c >= 0x1100 && c <= 0x115F);
+}
+
+inline auto is_hangul_syllable(code_point c) -> bool {
+  return c >= 0xAC00 && c <= 0xD7A3;
+}
+
+inline auto is_regional_indicator(code_point c) -> bool {
+  return c >= 0x1F1E6 && c <= 0x1F1FF;
+}
+
+/// Can the text be cut between the code points \a a and \a b?
+inline auto is_grapheme_boundary(code_point a, code_point b) -> bool {
+  if (a == '\r' && b == '\n') {
+    return false;
+  }
+  if (is_grapheme_extend(b)) {
+    return false;
+  }
+  // Emoji zero width joiner sequences
+  if (a == 0x200D) {
+    line_break_class lb = line_break_class_of(b);
+    return lb != line_break_class::id && lb != line_break_class::eb;
+  }
+  // Conjoining jamo
+  if (is_hangul_jamo_vt(b) && (is_hangul_leading(a) || is_hangul_jamo_vt(a) ||
+                               is_hangul_syllable(a))) {
+    return false;
+  }
+  if (is_hangul_leading(a) &&
+      (is_hangul_leading(b) || is_hangul_syllable(b))) {
+    return false;
+  }
+  return true;
+}
+
+/// Move the cut \a p, which is between two code points, back to the start of
+/// the grapheme cluster it falls in.
+template <typename CharType>
+auto grapheme_cut(CharType const *begin, CharType const *p,
+                  CharType const *end) -> CharType const * {
+  while (p != begin && p != end) {
+    CharType const *prev = previous_code_point(begin, p);
+    code_point a = code_point_at(prev, end);
+    code_point b = code_point_at(p, end);
+    if (is_regional_indicator(a) && is_regional_indicator(b)) {
+      // Cut between pairs: count the indicators before the cut
+      std::size_t count = 0;
+      CharType const *q = p;
+      while (q != begin) {
+        CharType const *r = previous_code_point(begin, q);
+        if (!is_regional_indicator(code_point_at(r, end))) {
+          break;
+        }
+        q = r;
+        ++count;
+      }
+      return count % 2 == 0 ? p : prev;
+    }
+    if (is_grapheme_boundary(a, b)) {
+      return p;
+    }
+    p = prev;
+  }
+  return p;
+}
+
+}  // namespace details
+/// \endcond
+
+///
+/// \brief The end of the longest prefix of [begin, end) that fits in
+/// \a max_units code units and does not end in the middle of a character.
+///
+/// In whole_code_point mode, this only looks at the code units around the
+/// cut: if it falls inside a multi unit sequence, the cut moves back to its
+/// first unit, which is at most max_width - 1 units away (located with
+/// is_trail() and checked with trail_length()). The cost is constant,
+/// whatever the size of the text. Ill-formed text is cut at \a max_units.
+///
+/// In grapheme mode, the cut then moves back code point by code point until
+/// it falls between two grapheme clusters, as approximated by the line
+/// breaking classes of the characters (see truncate_mode). The cost is bound
+/// by the length of the last cluster.
+///
+/// Nothing is allocated nor copied. Works with UTF-8, UTF-16 and UTF-32 text.
+///
+template <typename CharType>
+auto truncate(CharType const *begin, CharType const *end,
+              std::size_t max_units,
+              truncate_mode mode = truncate_mode::whole_code_point)
+    -> CharType const * {
+  using traits = utf_traits<CharType>;
+  if (static_cast<std::size_t>(end - begin) <= max_units) {
+    return end;
+  }
+  CharType const *cut = begin + max_units;
+  CharType const *lead = cut;
+  for (std::size_t i = 1; i < traits::max_width && lead != begin &&
+                          traits::is_trail(*lead);
+       ++i) {
+    --lead;
+  }
+  if (lead != cut) {
+    int trail = traits::trail_length(*lead);
+    if (trail > 0 && lead + trail >= cut) {
+      cut = lead;
+    }
+  }
+  if (mode == truncate_mode::grapheme) {
+    cut = details::grapheme_cut(begin, cut, end);
+  }
+  return cut;
+}
+
+///
+/// \brief Truncate \a str in place to at most \a max_units code units, without
+/// cutting a character in half.
+///
+/// See truncate(CharType const *, CharType const *, std::size_t,
+/// truncate_mode).
+///
+template <typename CharType, typename Traits, typename Allocator>
+void truncate(std::basic_string<CharType, Traits, Allocator> &str,
+              std::size_t max_units,
+              truncate_mode mode = truncate_mode::whole_code_point) {
+  CharType const *begin = str.data();
+  CharType const *cut = truncate(begin, begin + str.size(), max_units, mode);
+  str.resize(static_cast<std::size_t>(cut - begin));
+}
+
+}  // namespace utf
+}  // namespace nowide
@@ -7,6 +7,8 @@
 //
 #pragma once
 
+#include <common/config.h>
+
 #include <hedley/hedley.h>
 
 #include <cstddef>  // for std::size_t
@@ -138,6 +140,100 @@ struct utf_traits {
 
 #else  // DOXYGEN_DOCUMENTATION_BUILD
 
+/// \cond INTERNAL
+namespace details {
+
+///
+/// Byte classes of the table driven UTF-8 decoder (Bjoern Hoehrmann's DFA):
+/// bytes that always lead to the same transitions share a class.
+///
+inline auto utf8_byte_class(unsigned char byte) -> std::uint8_t {
+  static const std::uint8_t classes[256] = {
+      // 0x00..0x7F: ASCII
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //
+      // 0x80..0xBF: trail bytes, in three ranges
+      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  //
+      9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,  //
+      7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,  //
+      7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,  //
+      // 0xC0..0xDF: two byte leads (0xC0 and 0xC1 are always overlong)
+      8, 8, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,  //
+      2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,  //
+      // 0xE0..0xEF: three byte leads (0xED may start a surrogate)
+      10, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 3, 3,  //
+      // 0xF0..0xFF: four byte leads (0xF5 and up are out of range)
+      11, 6, 6, 6, 5, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8};
+  return classes[byte];
+}
+
+/// The accepting state of the DFA.
+static const std::uint8_t utf8_accept = 0;
+/// The rejecting state of the DFA.
+static const std::uint8_t utf8_reject = 12;
+
+///
+/// Transitions of the DFA: the next state is at index state + class. States
+/// are multiples of 12 so that no multiplication is needed.
+///
+inline auto utf8_transition(std::uint8_t state, std::uint8_t byte_class)
+    -> std::uint8_t {
+  static const std::uint8_t transitions[108] = {
+      0,  12, 24, 36, 60, 96, 84, 12, 12, 12, 48, 72,  // accept
+      12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,  // reject
+      12, 0,  12, 12, 12, 12, 12, 0,  12, 0,  12, 12,  // 1 trail left
+      12, 24, 12, 12, 12, 12, 12, 24, 12, 24, 12, 12,  // 2 trails left
+      12, 12, 12, 12, 12, 12, 12, 24, 12, 12, 12, 12,  // after E0
+      12, 24, 12, 12, 12, 12, 12, 12, 12, 24, 12, 12,  // after ED
+      12, 12, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12,  // after F0
+      12, 36, 12, 12, 12, 12, 12, 36, 12, 36, 12, 12,  // after F1..F3
+      12, 36, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12   // after F4
+  };
+  return transitions[state + byte_class];
+}
+
+///
+/// Table driven UTF-8 decoder, with the same contract as
+/// utf_traits<CharType, 1>::decode(). Overlong forms, surrogates and out of
+/// range values are rejected by the transitions themselves, as soon as the
+/// byte that makes the sequence invalid is read, so there is no separate
+/// check of the decoded value.
+///
+template <typename Iterator>
+auto decode_utf8_dfa(Iterator &p, Iterator e) -> code_point {
+  if (NOWIDE_UNLIKELY(p == e)) {
+    return incomplete;
+  }
+  auto byte = static_cast<unsigned char>(*p++);
+  if (byte < 0x80) {
+    return byte;
+  }
+  std::uint8_t byte_class = utf8_byte_class(byte);
+  code_point c = (0xFFU >> byte_class) & byte;
+  std::uint8_t state = utf8_transition(utf8_accept, byte_class);
+  while (state != utf8_accept) {
+    if (NOWIDE_UNLIKELY(state == utf8_reject)) {
+      return illegal;
+    }
+    if (NOWIDE_UNLIKELY(p == e)) {
+      return incomplete;
+    }
+    byte = static_cast<unsigned char>(*p++);
+    c = (c << 6) | (byte & 0x3FU);
+    state = utf8_transition(state, utf8_byte_class(byte));
+  }
+  return c;
+}
+
+}  // namespace details
+/// \endcond
+
 template <typename CharType, int size = sizeof(CharType)>
 struct utf_traits;
 
@@ -187,6 +283,9 @@ struct utf_traits<CharType, 1> {
 
   template <typename Iterator>
   static auto decode(Iterator &p, Iterator e) -> code_point {
+#if ASAP_UNICODE_DFA_DECODER
+    return details::decode_utf8_dfa(p, e);
+#else
     if (NOWIDE_UNLIKELY(p == e)) {
       return incomplete;
     }
@@ -263,6 +362,7 @@ struct utf_traits<CharType, 1> {
     }
 
     return c;
+#endif  // ASAP_UNICODE_DFA_DECODER
   }
 
   template <typename Iterator>
@@ -287,8 +387,16 @@ struct utf_traits<CharType, 1> {
     switch (trail_size) {  // NOLINT(hicpp-multiway-paths-covered)
       case 3:              // NOLINT(bugprone-branch-clone)
         c = (c << 6) | (static_cast<unsigned char>(*p++) & 0x3FU);
+#if defined(__clang__)
+        [[clang::fallthrough]];
+#endif  // __clang__
+        /* FALLTHRU */
       case 2:
         c = (c << 6) | (static_cast<unsigned char>(*p++) & 0x3FU);
+#if defined(__clang__)
+        [[clang::fallthrough]];
+#endif  // __clang__
+        /* FALLTHRU */
       case 1:
         c = (c << 6) | (static_cast<unsigned char>(*p++) & 0x3FU);
     }
@@ -8,94 +8,53 @@
 #include <common/platform.h>
 #include <hedley/hedley.h>
 
+#include <cstdarg>  // for va_start, va_end
+#include <cstdio>   // for snprintf
+
+// GCC and clang will complain if you call printf with a non-literal (and if
+// you call it with a literal format string, they will check the format string
+// against the provided arguments). The __attribute__((__format__ (__printf__,
+// ...) tells the compiler that one of your parameters is a printf format
+// string and causes the checking to be applied when that function is called.
+//
+// Since the compiler knows that the format string parameter will be checked
+// when your function is called, it won't complain about you using that
+// parameter as a format string inside your function.
+//
+// see: https://clang.llvm.org/docs/AttributeReference.html#format
+#if HEDLEY_HAS_ATTRIBUTE(format)
+#define ASAP_FORMAT(fmt, ellipsis) \
+  __attribute__((__format__(__printf__, fmt, ellipsis)))
+#else
+#define ASAP_FORMAT(fmt, ellipsis)
+#endif
+
 #if ASAP_USE_ASSERTS
 
+#include <common/stack_trace.h>
+
+#include <algorithm>  // for std::min
 #include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cinttypes>  // for PRId64 et.al.
 #include <csignal>
-#include <cstdarg>  // for va_start, va_end
-#include <cstdio>   // for snprintf
 #include <cstdlib>
 #include <cstring>  // for strncat
 #include <string>   // for strstr, strchr
+#include <thread>
 
-// __has_include is currently supported by GCC and Clang. However GCC 4.9 may
-// have issues and returns 1 for 'defined( __has_include )', while
-// '__has_include' is actually not supported:
-// https://gcc.gnu.org/bugzilla/show_bug.cgi?id=63662
-#if defined(__has_include) && (!HEDLEY_GNUC_VERSION || (__GNUC__ + 0) >= 5)
-#if __has_include(<cxxabi.h>)
-#define ASAP_HAS_CXXABI_H
-#endif
-#elif defined(__GLIBCXX__) || defined(__GLIBCPP__)
-#define ASAP_HAS_CXXABI_H
-#endif
+#include "demangle.h"
+#include "failure_record.h"
 
-#if defined(ASAP_HAS_CXXABI_H)
-#include <cxxabi.h>
-// For some architectures (mips, mips64, x86, x86_64) cxxabi.h in Android NDK is
-// implemented by gabi++ library
-// (https://android.googlesource.com/platform/ndk/+/master/sources/cxx-stl/gabi++/),
-// which does not implement abi::__cxa_demangle(). We detect this implementation
-// by checking the include guard here.
-#if defined(__GABIXX_CXXABI_H__)
-#undef ASAP_HAS_CXXABI_H
-#else
-#include <cstddef>
-#include <cstdlib>
+#if defined(ASAP_LINUX) && ASAP_USE_EXECINFO
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
-namespace {
-inline auto demangle_alloc(char const* name) noexcept -> char const*;
-inline void demangle_free(char const* name) noexcept;
-
-class scoped_demangled_name {
- private:
-  char const* m_p;
-
- public:
-  explicit scoped_demangled_name(char const* name) noexcept
-      : m_p(demangle_alloc(name)) {}
-
-  ~scoped_demangled_name() noexcept { demangle_free(m_p); }
-
-  auto get() const noexcept -> char const* { return m_p; }
-
-  scoped_demangled_name(scoped_demangled_name const&) = delete;
-  auto operator=(scoped_demangled_name const&)
-      -> scoped_demangled_name& = delete;
-};
-
-inline auto demangle_alloc(char const* name) noexcept -> char const* {
-  int status = 0;
-  std::size_t size = 0;
-  return abi::__cxa_demangle(name, nullptr, &size, &status);
-}
-
-inline void demangle_free(char const* name) noexcept {
-  std::free(const_cast<char*>(name));
-}
-
-inline auto demangle(char const* name) -> std::string {
-  scoped_demangled_name demangled_name(name);
-  char const* p = demangled_name.get();
-  if (p == nullptr) {
-    p = name;
-  }
-  return p;
-}
-}  // namespace
-#else   // !ASAP_HAS_CXXABI_H
-namespace {
-inline auto demangle_alloc(char const* name) noexcept -> char const* {
-  return name;
-}
-
-inline void demangle_free(char const* /*unused*/) noexcept {}
-
-inline auto demangle(char const* name) -> std::string { return name; }
-}  // namespace
-#endif  // ASAP_HAS_CXXABI_H
+using asap::details::demangle;
 
 #if ASAP_USE_EXECINFO
 #include <execinfo.h>
@@ -238,24 +197,6 @@ void print_backtrace(char* out, int len, int /*max_depth*/, void* /* ctx */) {
 #endif  // EXEC_INFO
 
 
-// GCC and clang will complain if you call printf with a non-literal (and if
-// you call it with a literal format string, they will check the format string
-// against the provided arguments). The __attribute__((__format__ (__printf__,
-// ...) tells the compiler that one of your parameters is a printf format
-// string and causes the checking to be applied when that function is called.
-// 
-// Since the compiler knows that the format string parameter will be checked
-// when your function is called, it won't complain about you using that
-// parameter as a format string inside your function.
-//
-// see: https://clang.llvm.org/docs/AttributeReference.html#format
-#if HEDLEY_HAS_ATTRIBUTE(format)
-#define ASAP_FORMAT(fmt, ellipsis) \
-  __attribute__((__format__(__printf__, fmt, ellipsis)))
-#else
-#define ASAP_FORMAT(fmt, ellipsis)
-#endif
-
 namespace {
 ASAP_FORMAT(1, 2)
 void assert_print(char const* fmt, ...) {
@@ -267,6 +208,123 @@ void assert_print(char const* fmt, ...) {
 }
 }  // namespace
 
+namespace {
+
+// The first thread to fail an assertion reports it; the others park until it
+// aborts the process, so that the reports do not interleave.
+std::atomic<bool> failing{false};
+thread_local bool in_assert_fail = false;
+
+std::atomic<bool> dump_threads{false};
+
+HEDLEY_NO_RETURN void park_thread() {
+  for (;;) {
+    std::this_thread::sleep_for(std::chrono::hours(1));
+  }
+}
+
+#if defined(ASAP_LINUX) && ASAP_USE_EXECINFO
+// Signal sent to the other threads to make them capture their stack
+auto dump_signal() -> int { return SIGRTMAX - 1; }
+const std::size_t max_dumped_threads = 256;
+// Frames of the handler: dump_handler() and the signal trampoline
+const std::size_t handler_frames = 2;
+
+struct thread_stack {
+  pid_t tid;
+  asap::stack_trace trace;
+  std::atomic<bool> ready;
+};
+
+// The report is preallocated: nothing is allocated from the signal handler
+thread_stack thread_stacks[max_dumped_threads];
+std::atomic<std::size_t> stacks_claimed{0};
+std::atomic<std::size_t> stacks_ready{0};
+
+auto current_tid() -> pid_t {
+  return static_cast<pid_t>(::syscall(SYS_gettid));
+}
+
+void dump_handler(int /*sig*/) {
+  // The interrupted code may be about to read errno
+  int saved_errno = errno;
+  std::size_t slot = stacks_claimed.fetch_add(1, std::memory_order_relaxed);
+  if (slot < max_dumped_threads) {
+    thread_stacks[slot].tid = current_tid();
+    thread_stacks[slot].trace = asap::stack_trace::capture(handler_frames);
+    thread_stacks[slot].ready.store(true, std::memory_order_release);
+  }
+  stacks_ready.fetch_add(1, std::memory_order_release);
+  errno = saved_errno;
+}
+
+void prepare_thread_dump() {
+  // The first capture loads the unwinder, which allocates
+  asap::stack_trace::capture();
+  struct sigaction action {};
+  action.sa_handler = &dump_handler;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(dump_signal(), &action, nullptr);
+}
+
+/// Signal all the threads but the calling one and wait, up to a second, for
+/// them to capture their stack. Returns the number of threads signaled.
+auto collect_thread_stacks() -> std::size_t {
+  prepare_thread_dump();
+  pid_t const self = current_tid();
+  pid_t const pid = ::getpid();
+  std::size_t signaled = 0;
+  DIR* tasks = ::opendir("/proc/self/task");
+  if (tasks == nullptr) {
+    return 0;
+  }
+  while (dirent* entry = ::readdir(tasks)) {
+    pid_t tid = static_cast<pid_t>(std::atoi(entry->d_name));
+    if (tid <= 0 || tid == self || signaled == max_dumped_threads) {
+      continue;
+    }
+    if (::syscall(SYS_tgkill, pid, tid, dump_signal()) == 0) {
+      ++signaled;
+    }
+  }
+  ::closedir(tasks);
+
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (stacks_ready.load(std::memory_order_acquire) < signaled &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return signaled;
+}
+
+void print_thread_stacks(std::size_t signaled) {
+  // Late answers may still be writing their slot: only print complete ones
+  std::size_t const slots = std::min(
+      stacks_claimed.load(std::memory_order_relaxed), max_dumped_threads);
+  std::size_t answered = 0;
+  for (std::size_t i = 0; i < slots; ++i) {
+    if (thread_stacks[i].ready.load(std::memory_order_acquire)) {
+      ++answered;
+    }
+  }
+  assert_print("threads: %zu signaled, %zu answered\n", signaled, answered);
+  for (std::size_t i = 0; i < slots; ++i) {
+    if (thread_stacks[i].ready.load(std::memory_order_acquire)) {
+      assert_print("thread %d:\n%s\n", static_cast<int>(thread_stacks[i].tid),
+                   thread_stacks[i].trace.to_string().c_str());
+    }
+  }
+}
+#else   // !ASAP_LINUX || !ASAP_USE_EXECINFO
+void prepare_thread_dump() {}
+auto collect_thread_stacks() -> std::size_t { return 0; }
+void print_thread_stacks(std::size_t /*signaled*/) {}
+#endif  // ASAP_LINUX && ASAP_USE_EXECINFO
+
+}  // namespace
+
 // we deliberately don't want asserts to be marked as no-return, since that
 // would trigger warnings in debug builds of any code coming after the assert
 #if HEDLEY_HAS_WARNING("-Wmissing-noreturn")
@@ -277,6 +335,20 @@ HEDLEY_DIAGNOSTIC_PUSH
 namespace asap {
 void assert_fail(char const* expr, int line, char const* file,
                  char const* function, char const* value, int kind) {
+  if (in_assert_fail) {
+    // An assertion failed while reporting another one
+    ::abort();
+  }
+  in_assert_fail = true;
+  if (failing.exchange(true)) {
+    park_thread();
+  }
+
+  std::size_t signaled = 0;
+  if (dump_threads.load()) {
+    signaled = collect_thread_stacks();
+  }
+
   char stack[8192];
   stack[0] = '\0';
   print_backtrace(stack, sizeof(stack), 0, nullptr);
@@ -300,8 +372,77 @@ void assert_fail(char const* expr, int line, char const* file,
       "%s\n",
       message, file, line, function, expr, value != nullptr ? value : "",
       value != nullptr ? "\n" : "", stack);
+  stack_trace const trace = stack_trace::capture();
+  details::write_failure_record({kind == 1 ? "precondition" : "assertion",
+                                 expr, file, line, function, value, 0, nullptr,
+                                 trace.begin(), trace.size()});
+  if (signaled != 0) {
+    print_thread_stacks(signaled);
+  }
   ::abort();
 }
+
+void set_assert_thread_dump(bool enabled) {
+  if (enabled) {
+    prepare_thread_dump();
+  }
+  dump_threads.store(enabled);
+}
+
+namespace details {
+namespace {
+ASAP_FORMAT(5, 6)
+void fail_with_value(char const* expr, int line, char const* file,
+                     char const* function, char const* fmt, ...) {
+  char value[1024];
+  va_list va;
+  va_start(va, fmt);
+  std::vsnprintf(value, sizeof(value), fmt, va);
+  va_end(va);
+  assert_fail(expr, line, file, function, value, 0);
+}
+}  // namespace
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name, bool value) {
+  fail_with_value(expr, line, file, function, "%s: %s", name,
+                  value ? "true" : "false");
+}
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name, char value) {
+  fail_with_value(expr, line, file, function, "%s: %c", name, value);
+}
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name, long long value) {
+  fail_with_value(expr, line, file, function, "%s: %lld", name, value);
+}
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name,
+                     unsigned long long value) {
+  fail_with_value(expr, line, file, function, "%s: %llu", name, value);
+}
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name, double value) {
+  fail_with_value(expr, line, file, function, "%s: %g", name, value);
+}
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name,
+                     char const* value) {
+  fail_with_value(expr, line, file, function, "%s: %s", name,
+                  value != nullptr ? value : "(null)");
+}
+
+void assert_fail_val(char const* expr, int line, char const* file,
+                     char const* function, char const* name,
+                     void const* value) {
+  fail_with_value(expr, line, file, function, "%s: %p", name, value);
+}
+}  // namespace details
 }  // namespace asap
 
 #if HEDLEY_HAS_WARNING("-Wmissing-noreturn")
@@ -313,13 +454,26 @@ HEDLEY_DIAGNOSTIC_POP
 // these are just here to make it possible for a client that built with debug
 // enable to be able to link against a release build (just possible, not
 // necessarily supported)
-namespace {
-ASAP_FORMAT(1, 2)
-void assert_print(char const*, ...) {}
-}  // namespace
 namespace asap {
 void assert_fail(char const*, int, char const*, char const*, char const*, int) {
 }
+void set_assert_thread_dump(bool) {}
+namespace details {
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     bool) {}
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     char) {}
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     long long) {}
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     unsigned long long) {}
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     double) {}
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     char const*) {}
+void assert_fail_val(char const*, int, char const*, char const*, char const*,
+                     void const*) {}
+}  // namespace details
 }  // namespace asap
 
 #endif  // ASAP_USE_ASSERTS
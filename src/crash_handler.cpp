@@ -0,0 +1,221 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#include <common/config.h>
+#include <common/crash_handler.h>
+
+#if defined(ASAP_POSIX)
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for std::uintptr_t
+
+#include <unistd.h>
+
+#if ASAP_USE_EXECINFO
+#include <execinfo.h>
+#endif
+
+#include "failure_record.h"
+#include "fd_writer.h"
+
+namespace {
+
+// Everything below runs in the signal handler: only async-signal-safe
+// functions, no allocation, no lock.
+
+using asap::details::fd_writer;
+
+const int crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL};
+const int crash_signal_count = sizeof(crash_signals) / sizeof(int);
+const int max_frames = 64;
+
+struct sigaction previous_actions[crash_signal_count];
+bool installed = false;
+std::atomic<int> report_fd{2};
+
+auto signal_name(int sig) -> char const * {
+  switch (sig) {
+    case SIGSEGV:
+      return "SIGSEGV";
+    case SIGBUS:
+      return "SIGBUS";
+    case SIGFPE:
+      return "SIGFPE";
+    case SIGILL:
+      return "SIGILL";
+    default:
+      return "signal";
+  }
+}
+
+void write_module(char const *line, std::size_t size, void *context) {
+  auto &out = *static_cast<fd_writer *>(context);
+  out.put(line, size);
+  out.put('\n');
+}
+
+void write_report(int fd, int sig, siginfo_t *info, void *const *frames,
+                  int count) {
+  fd_writer out(fd);
+  out.put("\nFatal signal ");
+  out.put_dec(sig);
+  out.put(" (");
+  out.put(signal_name(sig));
+  out.put(") at address ");
+  out.put_hex(reinterpret_cast<std::uintptr_t>(info->si_addr));
+  out.put(", pid ");
+  out.put_dec(static_cast<int>(::getpid()));
+  out.put("\nstack:\n");
+#if ASAP_USE_EXECINFO
+  for (int i = 0; i < count; ++i) {
+    out.put_dec(i + 1);
+    out.put(": ");
+    out.put_hex(reinterpret_cast<std::uintptr_t>(frames[i]));
+    out.put('\n');
+  }
+#else
+  static_cast<void>(frames);
+  static_cast<void>(count);
+  out.put("<not supported>\n");
+#endif
+  out.put("modules:\n");
+  asap::details::for_each_executable_mapping(&write_module, &out);
+}
+
+void crash_handler(int sig, siginfo_t *info, void * /*context*/) {
+  // The first crashing thread reports; the others wait for it to end the
+  // process
+  static std::atomic_flag reporting = ATOMIC_FLAG_INIT;
+  if (reporting.test_and_set()) {
+    for (;;) {
+      ::pause();
+    }
+  }
+  int saved_errno = errno;
+  void *frames[max_frames];
+  int count = 0;
+#if ASAP_USE_EXECINFO
+  count = ::backtrace(frames, max_frames);
+#endif
+  // Frame 0 is this handler
+  void *const *stack = frames + (count > 0 ? 1 : 0);
+  count = count > 0 ? count - 1 : 0;
+  write_report(report_fd.load(), sig, info, stack, count);
+  asap::details::write_failure_record(
+      {"crash", nullptr, nullptr, 0, nullptr, nullptr, sig, info->si_addr,
+       stack, static_cast<std::size_t>(count)});
+  errno = saved_errno;
+
+  // Die from the signal as if there was no handler; a fault that is not
+  // re-raised here happens again when the handler returns
+  struct sigaction action {};
+  action.sa_handler = SIG_DFL;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(sig, &action, nullptr);
+  ::raise(sig);
+}
+
+/// Alternate signal stack of a thread, released when the thread exits.
+class crash_stack {
+ public:
+  crash_stack() = default;
+  crash_stack(crash_stack const &) = delete;
+  auto operator=(crash_stack const &) -> crash_stack & = delete;
+
+  ~crash_stack() {
+    if (memory_ != nullptr) {
+      stack_t disable{};
+      disable.ss_flags = SS_DISABLE;
+      ::sigaltstack(&disable, nullptr);
+      delete[] memory_;
+    }
+  }
+
+  auto install() -> bool {
+    if (memory_ != nullptr) {
+      return true;
+    }
+    memory_ = new char[size];
+    stack_t stack{};
+    stack.ss_sp = memory_;
+    stack.ss_size = size;
+    if (::sigaltstack(&stack, nullptr) != 0) {
+      delete[] memory_;
+      memory_ = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  // Room for the handler, whatever the platform's MINSIGSTKSZ
+  static const std::size_t size = 64 * 1024;
+  char *memory_{nullptr};
+};
+
+}  // namespace
+
+namespace asap {
+
+auto install_crash_stack() -> bool {
+  static thread_local crash_stack stack;
+  return stack.install();
+}
+
+auto install_crash_handler(int fd) -> bool {
+  report_fd.store(fd);
+  if (installed) {
+    return true;
+  }
+#if ASAP_USE_EXECINFO
+  // The first call loads the unwinder, which allocates
+  void *frames[2];
+  ::backtrace(frames, 2);
+#endif
+  install_crash_stack();
+  struct sigaction action {};
+  action.sa_sigaction = &crash_handler;
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+  for (int i = 0; i < crash_signal_count; ++i) {
+    if (::sigaction(crash_signals[i], &action, &previous_actions[i]) != 0) {
+      for (int j = 0; j < i; ++j) {
+        ::sigaction(crash_signals[j], &previous_actions[j], nullptr);
+      }
+      return false;
+    }
+  }
+  installed = true;
+  return true;
+}
+
+void uninstall_crash_handler() {
+  if (!installed) {
+    return;
+  }
+  for (int i = 0; i < crash_signal_count; ++i) {
+    ::sigaction(crash_signals[i], &previous_actions[i], nullptr);
+  }
+  installed = false;
+}
+
+}  // namespace asap
+
+#else  // !ASAP_POSIX
+
+namespace asap {
+
+auto install_crash_handler(int /*fd*/) -> bool { return false; }
+
+auto install_crash_stack() -> bool { return false; }
+
+void uninstall_crash_handler() {}
+
+}  // namespace asap
+
+#endif  // ASAP_POSIX
@@ -0,0 +1,90 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+// Demangling of C++ symbol names, shared by the assertion and stack trace
+// implementations. Private to the library.
+
+#pragma once
+
+#include <hedley/hedley.h>
+
+#include <string>
+
+// __has_include is currently supported by GCC and Clang. However GCC 4.9 may
+// have issues and returns 1 for 'defined( __has_include )', while
+// '__has_include' is actually not supported:
+// https://gcc.gnu.org/bugzilla/show_bug.cgi?id=63662
+#if defined(__has_include) && (!HEDLEY_GNUC_VERSION || (__GNUC__ + 0) >= 5)
+#if __has_include(<cxxabi.h>)
+#define ASAP_HAS_CXXABI_H
+#endif
+#elif defined(__GLIBCXX__) || defined(__GLIBCPP__)
+#define ASAP_HAS_CXXABI_H
+#endif
+
+#if defined(ASAP_HAS_CXXABI_H)
+#include <cxxabi.h>
+// For some architectures (mips, mips64, x86, x86_64) cxxabi.h in Android NDK is
+// implemented by gabi++ library
+// (https://android.googlesource.com/platform/ndk/+/master/sources/cxx-stl/gabi++/),
+// which does not implement abi::__cxa_demangle(). We detect this implementation
+// by checking the include guard here.
+#if defined(__GABIXX_CXXABI_H__)
+#undef ASAP_HAS_CXXABI_H
+#else
+#include <cstddef>
+#include <cstdlib>
+#endif
+#endif  // ASAP_HAS_CXXABI_H
+
+namespace asap {
+namespace details {
+
+#if defined(ASAP_HAS_CXXABI_H)
+inline auto demangle_alloc(char const* name) noexcept -> char const* {
+  int status = 0;
+  std::size_t size = 0;
+  return abi::__cxa_demangle(name, nullptr, &size, &status);
+}
+
+inline void demangle_free(char const* name) noexcept {
+  std::free(const_cast<char*>(name));
+}
+#else   // !ASAP_HAS_CXXABI_H
+inline auto demangle_alloc(char const* name) noexcept -> char const* {
+  return name;
+}
+
+inline void demangle_free(char const* /*unused*/) noexcept {}
+#endif  // ASAP_HAS_CXXABI_H
+
+class scoped_demangled_name {
+ private:
+  char const* m_p;
+
+ public:
+  explicit scoped_demangled_name(char const* name) noexcept
+      : m_p(demangle_alloc(name)) {}
+
+  ~scoped_demangled_name() noexcept { demangle_free(m_p); }
+
+  auto get() const noexcept -> char const* { return m_p; }
+
+  scoped_demangled_name(scoped_demangled_name const&) = delete;
+  auto operator=(scoped_demangled_name const&)
+      -> scoped_demangled_name& = delete;
+};
+
+inline auto demangle(char const* name) -> std::string {
+  scoped_demangled_name demangled_name(name);
+  char const* p = demangled_name.get();
+  if (p == nullptr) {
+    p = name;
+  }
+  return p;
+}
+
+}  // namespace details
+}  // namespace asap
@@ -0,0 +1,46 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+// Structured failure records, written by the assertion and crash handlers.
+// Private to the library.
+
+#pragma once
+
+#include <cstddef>  // for std::size_t
+
+namespace asap {
+namespace details {
+
+/// What failed, as described in failure_report.h. Null strings and null
+/// pointers are written as null, and so is the line if there is no file.
+struct failure_record {
+  /// "assertion", "precondition" or "crash"
+  char const *kind;
+  char const *expression;
+  char const *file;
+  int line;
+  char const *function;
+  char const *value;
+  /// Fatal signal, 0 if none
+  int signal;
+  void const *address;
+  void *const *frames;
+  std::size_t frame_count;
+};
+
+/// Write \a record as a JSON line to the file descriptor set with
+/// set_failure_report_fd(), if any. Async-signal-safe.
+void write_failure_record(failure_record const &record);
+
+/// Call \a callback with each line of /proc/self/maps describing an
+/// executable mapping, newline excluded. Lines are truncated to 512 bytes.
+/// Async-signal-safe.
+void for_each_executable_mapping(void (*callback)(char const *line,
+                                                  std::size_t size,
+                                                  void *context),
+                                 void *context);
+
+}  // namespace details
+}  // namespace asap
@@ -0,0 +1,245 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#include <common/config.h>
+#include <common/failure_report.h>
+#include <common/platform.h>
+
+#include "failure_record.h"
+
+#include <atomic>
+
+#if defined(ASAP_POSIX)
+
+#include <cerrno>
+#include <cstdint>  // for std::uintptr_t
+#include <ctime>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(ASAP_LINUX)
+#include <sys/syscall.h>
+#endif
+
+#include "fd_writer.h"
+
+namespace {
+
+// Everything below may run in a signal handler: only async-signal-safe
+// functions, no allocation, no lock.
+
+using asap::details::fd_writer;
+
+std::atomic<int> record_fd{-1};
+
+auto thread_id() -> unsigned long long {
+#if defined(ASAP_LINUX)
+  return static_cast<unsigned long long>(::syscall(SYS_gettid));
+#elif defined(ASAP_APPLE)
+  std::uint64_t tid = 0;
+  ::pthread_threadid_np(nullptr, &tid);
+  return tid;
+#else
+  return 0;
+#endif
+}
+
+/// Parse the hexadecimal number at \a pos of \a line, and move past it.
+auto parse_hex(char const *line, std::size_t size, std::size_t &pos)
+    -> std::uintptr_t {
+  std::uintptr_t value = 0;
+  for (; pos < size; ++pos) {
+    char c = line[pos];
+    int digit = c >= '0' && c <= '9'   ? c - '0'
+                : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                                       : -1;
+    if (digit < 0) {
+      break;
+    }
+    value = value * 16 + static_cast<std::uintptr_t>(digit);
+  }
+  return value;
+}
+
+/// Move past the field at \a pos of \a line and the spaces after it.
+void skip_field(char const *line, std::size_t size, std::size_t &pos) {
+  while (pos < size && line[pos] != ' ') {
+    ++pos;
+  }
+  while (pos < size && line[pos] == ' ') {
+    ++pos;
+  }
+}
+
+struct module_writer {
+  fd_writer &out;
+  bool first;
+};
+
+/// One module: `start-end perms offset dev inode path` from /proc/self/maps.
+void write_module(char const *line, std::size_t size, void *context) {
+  auto &modules = *static_cast<module_writer *>(context);
+  std::size_t pos = 0;
+  std::uintptr_t start = parse_hex(line, size, pos);
+  ++pos;
+  std::uintptr_t end = parse_hex(line, size, pos);
+  skip_field(line, size, pos);
+  skip_field(line, size, pos);
+  std::uintptr_t offset = parse_hex(line, size, pos);
+  skip_field(line, size, pos);
+  skip_field(line, size, pos);
+  skip_field(line, size, pos);
+
+  fd_writer &out = modules.out;
+  if (!modules.first) {
+    out.put(',');
+  }
+  modules.first = false;
+  out.put("{\"start\":\"");
+  out.put_hex(start);
+  out.put("\",\"end\":\"");
+  out.put_hex(end);
+  out.put("\",\"offset\":\"");
+  out.put_hex(offset);
+  out.put("\",\"path\":");
+  out.put_json(line + pos, size - pos);
+  out.put('}');
+}
+
+}  // namespace
+
+namespace asap {
+
+void set_failure_report_fd(int fd) { record_fd.store(fd < 0 ? -1 : fd); }
+
+auto failure_report_fd() -> int { return record_fd.load(); }
+
+namespace details {
+
+void for_each_executable_mapping(void (*callback)(char const *line,
+                                                  std::size_t size,
+                                                  void *context),
+                                 void *context) {
+  int maps = ::open("/proc/self/maps", O_RDONLY);
+  if (maps < 0) {
+    return;
+  }
+  char chunk[1024];
+  char line[512];
+  std::size_t size = 0;
+  for (;;) {
+    ssize_t got = ::read(maps, chunk, sizeof(chunk));
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      break;
+    }
+    for (ssize_t i = 0; i < got; ++i) {
+      if (chunk[i] != '\n') {
+        if (size < sizeof(line)) {
+          line[size++] = chunk[i];
+        }
+        continue;
+      }
+      // address perms offset dev inode path: keep the executable ones
+      std::size_t perms = 0;
+      while (perms < size && line[perms] != ' ') {
+        ++perms;
+      }
+      if (perms + 3 < size && line[perms + 3] == 'x') {
+        callback(line, size, context);
+      }
+      size = 0;
+    }
+  }
+  ::close(maps);
+}
+
+void write_failure_record(failure_record const &record) {
+  int fd = record_fd.load();
+  if (fd < 0) {
+    return;
+  }
+  timespec now{};
+  ::clock_gettime(CLOCK_REALTIME, &now);
+
+  fd_writer out(fd);
+  out.put("{\"kind\":");
+  out.put_json_or_null(record.kind);
+  out.put(",\"expression\":");
+  out.put_json_or_null(record.expression);
+  out.put(",\"file\":");
+  out.put_json_or_null(record.file);
+  out.put(",\"line\":");
+  if (record.file != nullptr) {
+    out.put_dec(record.line);
+  } else {
+    out.put("null");
+  }
+  out.put(",\"function\":");
+  out.put_json_or_null(record.function);
+  out.put(",\"value\":");
+  out.put_json_or_null(record.value);
+  out.put(",\"signal\":");
+  if (record.signal != 0) {
+    out.put_dec(record.signal);
+    out.put(",\"address\":\"");
+    out.put_hex(reinterpret_cast<std::uintptr_t>(record.address));
+    out.put('"');
+  } else {
+    out.put("null,\"address\":null");
+  }
+  out.put(",\"pid\":");
+  out.put_dec(static_cast<long long>(::getpid()));
+  out.put(",\"thread\":");
+  out.put_dec(thread_id());
+  out.put(",\"timestamp_ns\":");
+  out.put_dec(static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL +
+              static_cast<unsigned long long>(now.tv_nsec));
+  out.put(",\"frames\":[");
+  for (std::size_t i = 0; i < record.frame_count; ++i) {
+    if (i != 0) {
+      out.put(',');
+    }
+    out.put('"');
+    out.put_hex(reinterpret_cast<std::uintptr_t>(record.frames[i]));
+    out.put('"');
+  }
+  out.put("],\"modules\":[");
+  module_writer modules{out, true};
+  for_each_executable_mapping(&write_module, &modules);
+  out.put("]}\n");
+}
+
+}  // namespace details
+}  // namespace asap
+
+#else  // !ASAP_POSIX
+
+namespace {
+std::atomic<int> record_fd{-1};
+}  // namespace
+
+namespace asap {
+
+void set_failure_report_fd(int fd) { record_fd.store(fd < 0 ? -1 : fd); }
+
+auto failure_report_fd() -> int { return record_fd.load(); }
+
+namespace details {
+
+void for_each_executable_mapping(void (* /*callback*/)(char const *,
+                                                       std::size_t, void *),
+                                 void * /*context*/) {}
+
+void write_failure_record(failure_record const & /*record*/) {}
+
+}  // namespace details
+}  // namespace asap
+
+#endif  // ASAP_POSIX
@@ -0,0 +1,192 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+// Formatting to a file descriptor without stdio nor allocation, usable from a
+// signal handler. Shared by the crash handler and the failure reports. Private
+// to the library, POSIX only.
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for std::uintptr_t
+
+#include <unistd.h>
+
+namespace asap {
+namespace details {
+
+/// Buffered writer on a file descriptor. Only calls write(), which is
+/// async-signal-safe; output that fits in the buffer goes out in one call.
+class fd_writer {
+ public:
+  explicit fd_writer(int fd) : fd_(fd) {}
+  ~fd_writer() { flush(); }
+
+  fd_writer(fd_writer const &) = delete;
+  auto operator=(fd_writer const &) -> fd_writer & = delete;
+
+  void put(char c) {
+    if (size_ == sizeof(buffer_)) {
+      flush();
+    }
+    buffer_[size_++] = c;
+  }
+
+  void put(char const *str) {
+    for (; *str != '\0'; ++str) {
+      put(*str);
+    }
+  }
+
+  void put(char const *str, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      put(str[i]);
+    }
+  }
+
+  void put_hex(std::uintptr_t value) {
+    char digits[2 * sizeof(value)];
+    int count = 0;
+    do {
+      digits[count++] = "0123456789abcdef"[value & 0xF];
+      value >>= 4;
+    } while (value != 0);
+    put("0x");
+    while (count > 0) {
+      put(digits[--count]);
+    }
+  }
+
+  void put_dec(unsigned long long value) {
+    char digits[20];
+    int count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+      put(digits[--count]);
+    }
+  }
+
+  void put_dec(long long value) {
+    auto magnitude = static_cast<unsigned long long>(value);
+    if (value < 0) {
+      put('-');
+      magnitude = 0ULL - magnitude;
+    }
+    put_dec(magnitude);
+  }
+
+  void put_dec(int value) { put_dec(static_cast<long long>(value)); }
+
+  /// A JSON string literal, quotes included: quotation marks, reverse solidi
+  /// and control characters are escaped, and each byte that is not part of a
+  /// well-formed UTF-8 sequence is replaced by \ufffd, so that the output is
+  /// always valid JSON. Other bytes are copied as is.
+  void put_json(char const *str, std::size_t size) {
+    put('"');
+    for (std::size_t i = 0; i < size;) {
+      auto c = static_cast<unsigned char>(str[i]);
+      if (c == '"' || c == '\\') {
+        put('\\');
+        put(str[i++]);
+      } else if (c < 0x20) {
+        put("\\u00");
+        put("0123456789abcdef"[c >> 4]);
+        put("0123456789abcdef"[c & 0xF]);
+        ++i;
+      } else if (c < 0x80) {
+        put(str[i++]);
+      } else if (std::size_t length = utf8_sequence(str + i, size - i)) {
+        put(str + i, length);
+        i += length;
+      } else {
+        put("\\ufffd");
+        ++i;
+      }
+    }
+    put('"');
+  }
+
+  void put_json(char const *str) {
+    std::size_t size = 0;
+    while (str[size] != '\0') {
+      ++size;
+    }
+    put_json(str, size);
+  }
+
+  /// put_json(), or null for a null pointer.
+  void put_json_or_null(char const *str) {
+    if (str == nullptr) {
+      put("null");
+    } else {
+      put_json(str);
+    }
+  }
+
+  void flush() {
+    char const *p = buffer_;
+    while (size_ > 0) {
+      ssize_t written = ::write(fd_, p, size_);
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+      if (written <= 0) {
+        break;
+      }
+      p += written;
+      size_ -= static_cast<std::size_t>(written);
+    }
+    size_ = 0;
+  }
+
+ private:
+  /// Length of the well-formed UTF-8 sequence that starts with the non ASCII
+  /// byte \a str[0], or 0 if there is none.
+  static auto utf8_sequence(char const *str, std::size_t size)
+      -> std::size_t {
+    auto lead = static_cast<unsigned char>(str[0]);
+    std::size_t length = 0;
+    // Range of the second byte, narrower after some lead bytes to rule out
+    // overlong forms, surrogates and code points past U+10FFFF
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+      low = lead == 0xE0 ? 0xA0 : 0x80;
+      high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+      low = lead == 0xF0 ? 0x90 : 0x80;
+      high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+      return 0;
+    }
+    if (size < length) {
+      return 0;
+    }
+    for (std::size_t i = 1; i < length; ++i) {
+      auto c = static_cast<unsigned char>(str[i]);
+      if (c < low || c > high) {
+        return 0;
+      }
+      low = 0x80;
+      high = 0xBF;
+    }
+    return length;
+  }
+
+  int fd_;
+  char buffer_[4096];
+  std::size_t size_{0};
+};
+
+}  // namespace details
+}  // namespace asap
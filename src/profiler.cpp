@@ -0,0 +1,278 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#include <common/config.h>
+#include <common/profiler.h>
+#include <common/stack_trace.h>
+#include <hedley/hedley.h>
+
+#if defined(ASAP_POSIX) && ASAP_USE_EXECINFO
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>  // for snprintf
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <sys/time.h>
+
+namespace {
+
+/// Single producer (the signal handler of the owning thread), single consumer
+/// (the thread draining the samples) ring of stack traces.
+struct sample_ring {
+  explicit sample_ring(std::size_t size)
+      : capacity(size), samples(new asap::stack_trace[size]) {}
+
+  const std::size_t capacity;
+  std::unique_ptr<asap::stack_trace[]> samples;
+  /// Number of samples written
+  std::atomic<std::uint64_t> head{0};
+  /// Number of samples read
+  std::atomic<std::uint64_t> tail{0};
+  /// Whether a thread records samples in the ring
+  std::atomic<bool> owned{true};
+  /// Next ring in the list of all the rings
+  sample_ring *next{nullptr};
+};
+
+// All the rings ever allocated, most recent first. Rings are never freed:
+// the ring of a thread that exited is reused by a thread registered after it
+// was drained.
+std::atomic<sample_ring *> rings{nullptr};
+std::atomic<std::uint64_t> ring_count{0};
+
+// The ring of the calling thread. The initial exec model makes sure that
+// accessing it from the signal handler does not allocate.
+#if HEDLEY_HAS_ATTRIBUTE(tls_model)
+__attribute__((tls_model("initial-exec")))
+#endif
+thread_local sample_ring *thread_ring = nullptr;
+
+/// Gives the ring of the thread back when the thread exits. Kept apart from
+/// thread_ring, which the signal handler reads and must stay trivial.
+struct ring_owner {
+  ~ring_owner() {
+    if (ring != nullptr) {
+      thread_ring = nullptr;
+      // No sample may hit the ring once it is given back
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+      ring->owned.store(false, std::memory_order_release);
+    }
+  }
+
+  sample_ring *ring{nullptr};
+};
+
+thread_local ring_owner thread_ring_owner;
+
+std::atomic<std::size_t> ring_capacity{1024};
+std::atomic<std::uint64_t> dropped{0};
+std::atomic<std::uint64_t> unregistered{0};
+std::atomic<std::uint64_t> recorded{0};
+
+std::mutex control_mutex;
+bool running = false;
+// Only one thread at a time reads the rings
+std::mutex drain_mutex;
+struct sigaction previous_action;
+
+// Frames of the handler: profiler_handler() and the signal trampoline
+const std::size_t handler_frames = 2;
+
+void profiler_handler(int /*sig*/) {
+  // The interrupted code may be about to read errno
+  int saved_errno = errno;
+  sample_ring *ring = thread_ring;
+  if (ring == nullptr) {
+    unregistered.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    std::uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) == ring->capacity) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      ring->samples[head % ring->capacity] =
+          asap::stack_trace::capture(handler_frames);
+      ring->head.store(head + 1, std::memory_order_release);
+      recorded.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  errno = saved_errno;
+}
+
+/// A drained ring of \a capacity samples given back by its thread, now owned
+/// by the caller, or nullptr if there is none.
+auto reuse_ring(std::size_t capacity) -> sample_ring * {
+  for (sample_ring *ring = rings.load(std::memory_order_acquire);
+       ring != nullptr; ring = ring->next) {
+    bool owned = false;
+    if (ring->capacity != capacity ||
+        ring->owned.load(std::memory_order_relaxed) ||
+        !ring->owned.compare_exchange_strong(owned, true,
+                                             std::memory_order_acquire)) {
+      continue;
+    }
+    if (ring->tail.load(std::memory_order_acquire) ==
+        ring->head.load(std::memory_order_relaxed)) {
+      return ring;
+    }
+    ring->owned.store(false, std::memory_order_release);
+  }
+  return nullptr;
+}
+
+void set_timer(int frequency_hz) {
+  itimerval timer{};
+  if (frequency_hz > 0) {
+    long period_us = 1000000L / frequency_hz;
+    timer.it_interval.tv_sec = period_us / 1000000L;
+    timer.it_interval.tv_usec =
+        static_cast<suseconds_t>(period_us % 1000000L);
+    timer.it_value = timer.it_interval;
+  }
+  ::setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+/// One frame of a folded stack: its function name, or its address.
+auto frame_name(asap::stack_trace const &trace, std::size_t index)
+    -> std::string {
+  std::string name = trace.symbol(index);
+  if (name.empty()) {
+    char address[32];
+    std::snprintf(address, sizeof(address), "%p", trace[index]);
+    return address;
+  }
+  // Semicolons separate the frames
+  for (char &c : name) {
+    if (c == ';') {
+      c = ':';
+    }
+  }
+  return name;
+}
+
+}  // namespace
+
+namespace asap {
+
+auto start_profiler(int frequency_hz, std::size_t samples_per_thread) -> bool {
+  std::lock_guard<std::mutex> lock(control_mutex);
+  if (running || frequency_hz <= 0 || frequency_hz > 1000000 ||
+      samples_per_thread == 0) {
+    return false;
+  }
+  ring_capacity.store(samples_per_thread);
+  dropped.store(0);
+  unregistered.store(0);
+  recorded.store(0);
+  // The first capture loads the unwinder, which allocates
+  stack_trace::capture();
+  profiler_register_thread();
+
+  struct sigaction action {};
+  action.sa_handler = &profiler_handler;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (::sigaction(SIGPROF, &action, &previous_action) != 0) {
+    return false;
+  }
+  set_timer(frequency_hz);
+  running = true;
+  return true;
+}
+
+void stop_profiler() {
+  std::lock_guard<std::mutex> lock(control_mutex);
+  if (!running) {
+    return;
+  }
+  set_timer(0);
+  ::sigaction(SIGPROF, &previous_action, nullptr);
+  running = false;
+}
+
+void profiler_register_thread() {
+  if (thread_ring != nullptr) {
+    return;
+  }
+  std::size_t capacity = ring_capacity.load();
+  sample_ring *ring = reuse_ring(capacity);
+  if (ring == nullptr) {
+    ring = new sample_ring(capacity);
+    sample_ring *first = rings.load(std::memory_order_relaxed);
+    do {
+      ring->next = first;
+    } while (!rings.compare_exchange_weak(first, ring,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+    ring_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  thread_ring_owner.ring = ring;
+  thread_ring = ring;
+}
+
+auto profiler_folded_stacks() -> std::string {
+  std::map<std::string, std::uint64_t> stacks;
+  std::lock_guard<std::mutex> lock(drain_mutex);
+  for (sample_ring *ring = rings.load(std::memory_order_acquire);
+       ring != nullptr; ring = ring->next) {
+    std::uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    std::uint64_t head = ring->head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      stack_trace const &trace = ring->samples[tail % ring->capacity];
+      std::string folded;
+      for (std::size_t i = trace.size(); i > 0; --i) {
+        if (!folded.empty()) {
+          folded += ';';
+        }
+        folded += frame_name(trace, i - 1);
+      }
+      if (!folded.empty()) {
+        ++stacks[folded];
+      }
+      // Give the slot back to the handler only once it is read
+      ring->tail.store(tail + 1, std::memory_order_release);
+    }
+  }
+  std::string result;
+  for (auto const &stack : stacks) {
+    result += stack.first;
+    result += ' ';
+    result += std::to_string(stack.second);
+    result += '\n';
+  }
+  return result;
+}
+
+auto profiler_stats() -> profiler_statistics {
+  return {recorded.load(), dropped.load(), unregistered.load(),
+          ring_count.load()};
+}
+
+}  // namespace asap
+
+#else  // !ASAP_POSIX || !ASAP_USE_EXECINFO
+
+namespace asap {
+
+auto start_profiler(int /*frequency_hz*/, std::size_t /*samples_per_thread*/)
+    -> bool {
+  return false;
+}
+
+void stop_profiler() {}
+
+void profiler_register_thread() {}
+
+auto profiler_folded_stacks() -> std::string { return std::string(); }
+
+auto profiler_stats() -> profiler_statistics { return {0, 0, 0, 0}; }
+
+}  // namespace asap
+
+#endif  // ASAP_POSIX && ASAP_USE_EXECINFO
@@ -0,0 +1,98 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#include <common/soft_assert.h>
+
+#include <chrono>
+#include <cstdio>  // for fprintf
+
+namespace asap {
+
+namespace {
+
+void print_report(soft_assert_report const& report) {
+  std::fprintf(stderr,
+               "Soft assertion failed (%llu times, %llu not reported).\n"
+               "file: '%s'\n"
+               "line: %d\n"
+               "function: %s\n"
+               "expression: %s\n",
+               static_cast<unsigned long long>(report.hits),
+               static_cast<unsigned long long>(report.suppressed),
+               report.site.file, report.site.line, report.site.function,
+               report.site.expr);
+}
+
+std::atomic<soft_assert_handler> handler{nullptr};
+std::atomic<std::uint64_t> first_reports{10};
+std::atomic<std::int64_t> interval_ns{1000000000};
+// Sites that failed at least once, most recent first; never shrinks
+std::atomic<soft_assert_site*> sites{nullptr};
+
+auto now_ns() -> std::int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void register_site(soft_assert_site& site) {
+  soft_assert_site* head = sites.load(std::memory_order_relaxed);
+  do {
+    site.next = head;
+  } while (!sites.compare_exchange_weak(head, &site, std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+}  // namespace
+
+auto set_soft_assert_handler(soft_assert_handler new_handler)
+    -> soft_assert_handler {
+  return handler.exchange(new_handler);
+}
+
+void set_soft_assert_rate_limit(std::uint64_t reports,
+                                std::int64_t interval_ms) {
+  first_reports.store(reports, std::memory_order_relaxed);
+  interval_ns.store(interval_ms * 1000000, std::memory_order_relaxed);
+}
+
+auto soft_assert_snapshot() -> std::vector<soft_assert_stats> {
+  std::vector<soft_assert_stats> result;
+  for (soft_assert_site* site = sites.load(std::memory_order_acquire);
+       site != nullptr; site = site->next) {
+    result.push_back({site->expr, site->file, site->line, site->function,
+                      site->hits.load(std::memory_order_relaxed),
+                      site->reports.load(std::memory_order_relaxed)});
+  }
+  return result;
+}
+
+void soft_assert_fail(soft_assert_site& site) {
+  std::uint64_t hits = site.hits.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (hits == 1) {
+    register_site(site);
+  }
+  std::int64_t now = now_ns();
+  if (hits > first_reports.load(std::memory_order_relaxed)) {
+    // Only one of the threads that see an expired interval reports
+    std::int64_t last = site.last_report.load(std::memory_order_relaxed);
+    if (now - last < interval_ns.load(std::memory_order_relaxed) ||
+        !site.last_report.compare_exchange_strong(
+            last, now, std::memory_order_relaxed)) {
+      return;
+    }
+  } else {
+    site.last_report.store(now, std::memory_order_relaxed);
+  }
+  std::uint64_t reports =
+      site.reports.fetch_add(1, std::memory_order_relaxed) + 1;
+  soft_assert_handler report = handler.load(std::memory_order_acquire);
+  if (report == nullptr) {
+    report = &print_report;
+  }
+  report({site, hits, hits > reports ? hits - reports : 0});
+}
+
+}  // namespace asap
@@ -0,0 +1,150 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#include <common/config.h>
+#include <common/platform.h>
+#include <common/stack_trace.h>
+#include <hedley/hedley.h>
+
+#include <algorithm>  // for std::min
+#include <cstdint>    // for std::uintptr_t
+#include <cstdio>     // for snprintf
+#include <cstring>    // for std::memcpy
+#include <mutex>
+#include <unordered_map>
+
+#include "demangle.h"
+
+#if ASAP_USE_EXECINFO
+#include <dlfcn.h>
+#include <execinfo.h>
+#elif defined(ASAP_WINDOWS)
+// Keep the min and max macros of windows.h from breaking std::min
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+// clang-format off
+#include "windows.h"
+// clang-format on
+#endif
+
+namespace asap {
+
+constexpr std::size_t stack_trace::max_frames;
+
+namespace {
+
+/// Frames that capture() can skip, on top of its own.
+const std::size_t max_skip = 32;
+
+struct symbol_info {
+  /// Demangled name, empty if unknown
+  std::string name;
+  /// Offset of the address in the function
+  std::uintptr_t offset;
+};
+
+/// Process wide cache of the symbols of the return addresses seen so far.
+class symbol_cache {
+ public:
+  static auto instance() -> symbol_cache & {
+    static symbol_cache cache;
+    return cache;
+  }
+
+  auto lookup(void *address) -> symbol_info {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto found = symbols_.find(address);
+      if (found != symbols_.end()) {
+        return found->second;
+      }
+    }
+    // Symbolize without holding the lock
+    symbol_info info = symbolize(address);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return symbols_.emplace(address, info).first->second;
+  }
+
+ private:
+  static auto symbolize(void *address) -> symbol_info {
+    symbol_info info{std::string(), 0};
+#if ASAP_USE_EXECINFO
+    // A return address may be just past the end of its function, after a
+    // call that does not return: look up the call instruction instead
+    Dl_info dl{};
+    if (::dladdr(static_cast<char *>(address) - 1, &dl) != 0 &&
+        dl.dli_sname != nullptr) {
+      info.name = details::demangle(dl.dli_sname);
+      info.offset = reinterpret_cast<std::uintptr_t>(address) -
+                    reinterpret_cast<std::uintptr_t>(dl.dli_saddr);
+    }
+#else
+    static_cast<void>(address);
+#endif
+    return info;
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<void *, symbol_info> symbols_;
+};
+
+}  // namespace
+
+HEDLEY_NEVER_INLINE auto stack_trace::capture(std::size_t skip)
+    -> stack_trace {
+  stack_trace trace;
+  skip = std::min(skip, max_skip);
+#if ASAP_USE_EXECINFO
+  void *frames[max_frames + max_skip + 1];
+  int count = ::backtrace(frames, static_cast<int>(max_frames + skip + 1));
+  // Frame 0 is capture() itself
+  std::size_t first = skip + 1;
+  if (static_cast<std::size_t>(count) > first) {
+    trace.size_ = static_cast<std::size_t>(count) - first;
+    std::memcpy(trace.frames_.data(), frames + first,
+                trace.size_ * sizeof(void *));
+  }
+#elif defined(ASAP_WINDOWS)
+  trace.size_ = ::RtlCaptureStackBackTrace(static_cast<DWORD>(skip + 1),
+                                           static_cast<DWORD>(max_frames),
+                                           trace.frames_.data(), nullptr);
+#endif
+  return trace;
+}
+
+auto stack_trace::symbol(std::size_t index) const -> std::string {
+  return symbol_cache::instance().lookup(frames_[index]).name;
+}
+
+auto stack_trace::to_string() const -> std::string {
+  std::string result;
+  char line[64];
+  for (std::size_t i = 0; i < size_; ++i) {
+    symbol_info info = symbol_cache::instance().lookup(frames_[i]);
+    std::snprintf(line, sizeof(line), "%2u: %p", static_cast<unsigned>(i),
+                  frames_[i]);
+    result += line;
+    if (!info.name.empty()) {
+      std::snprintf(line, sizeof(line), "+0x%llx",
+                    static_cast<unsigned long long>(info.offset));
+      result += ' ';
+      result += info.name;
+      result += line;
+    }
+    result += '\n';
+  }
+  return result;
+}
+
+auto stack_trace::hash() const -> std::size_t {
+  std::uint64_t h = 0xCBF29CE484222325ULL;
+  for (std::size_t i = 0; i < size_; ++i) {
+    h = (h ^ reinterpret_cast<std::uintptr_t>(frames_[i])) * 0x100000001B3ULL;
+  }
+  return static_cast<std::size_t>(h ^ (h >> 32));
+}
+
+}  // namespace asap
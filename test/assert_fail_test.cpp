@@ -0,0 +1,144 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/assert.h>
+#include <common/config.h>
+#include <common/platform.h>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if ASAP_USE_ASSERTS && defined(ASAP_POSIX)
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/// Run \a fail in a child process and return what it writes on stderr. \a sig
+/// is the signal that killed it.
+template <typename Function>
+auto failure_report(Function fail, int &sig) -> std::string {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  pid_t pid = ::fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    ::close(fds[0]);
+    ::dup2(fds[1], 2);
+    // Not the handler of the test framework, which would report a failure
+    std::signal(SIGABRT, SIG_DFL);
+    fail();
+    ::_exit(0);
+  }
+  ::close(fds[1]);
+  std::string report;
+  char buffer[4096];
+  ssize_t got;
+  while ((got = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    report.append(buffer, static_cast<std::size_t>(got));
+  }
+  ::close(fds[0]);
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  sig = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+  return report;
+}
+
+auto count(std::string const &text, std::string const &pattern)
+    -> std::size_t {
+  std::size_t found = 0;
+  for (auto pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + pattern.size())) {
+    ++found;
+  }
+  return found;
+}
+
+void fail_in_threads() {
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&go]() {
+      while (!go.load()) {
+      }
+      asap::assert_fail("false", __LINE__, __FILE__, "fail_in_threads",
+                        nullptr);
+    });
+  }
+  go.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void fail_with_thread_dump() {
+  asap::set_assert_thread_dump(true);
+  std::atomic<int> started{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace_back([&started]() {
+      ++started;
+      for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    });
+  }
+  while (started.load() != 2) {
+    std::this_thread::yield();
+  }
+  asap::assert_fail("false", __LINE__, __FILE__, "fail_with_thread_dump",
+                    nullptr);
+}
+
+}  // namespace
+
+TEST_CASE("AssertFail / first failure wins", "[common][assert]") {
+  int sig = 0;
+  std::string report = failure_report(&fail_in_threads, sig);
+  REQUIRE(sig == SIGABRT);
+  REQUIRE(count(report, "Assertion failed.") == 1);
+  REQUIRE(count(report, "expression: false") == 1);
+}
+
+#if defined(ASAP_LINUX) && ASAP_USE_EXECINFO
+TEST_CASE("AssertFail / thread dump", "[common][assert]") {
+  int sig = 0;
+  std::string report = failure_report(&fail_with_thread_dump, sig);
+  REQUIRE(sig == SIGABRT);
+  REQUIRE(count(report, "Assertion failed.") == 1);
+  REQUIRE(count(report, "\nthreads: ") == 1);
+  // Runtimes, e.g. sanitizers, may have threads of their own
+  REQUIRE(count(report, "\nthread ") >= 2);
+}
+#endif  // ASAP_LINUX && ASAP_USE_EXECINFO
+
+#endif  // ASAP_USE_ASSERTS && ASAP_POSIX
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -0,0 +1,75 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+// This translation unit is built with assertions off, whatever the level of
+// the build.
+#define ASAP_ASSERT_LEVEL ASAP_ASSERT_LEVEL_OFF
+#include <common/assert.h>
+#include <common/soft_assert.h>
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>  // for std::size_t
+
+namespace {
+auto sum_first(int const *values, std::size_t count) -> int {
+  ASAP_ASSUME(count % 4 == 0);
+  int sum = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+}  // namespace
+
+TEST_CASE("TestAssertionLevelOff", "[common][assert]") {
+  int evaluated = 0;
+  auto check = [&evaluated]() {
+    ++evaluated;
+    return false;
+  };
+  ASAP_ASSERT(check());
+  ASAP_ASSERT_PRECOND(check());
+  ASAP_ASSERT_VAL(check(), evaluated);
+  ASAP_ASSERT_AUDIT(check());
+  static_cast<void>(check);
+  REQUIRE(evaluated == 0);
+
+  int values[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  REQUIRE(sum_first(values, 8) == 36);
+}
+
+#if ASAP_SOFT_ASSERTS
+TEST_CASE("TestAssertionLevelOff / soft", "[common][assert][soft]") {
+  // Soft assertions have their own switch and stay on
+  int evaluated = 0;
+  auto check = [&evaluated]() {
+    ++evaluated;
+    return true;
+  };
+  ASAP_ASSERT_SOFT(check());
+  REQUIRE(evaluated == 1);
+}
+#endif  // ASAP_SOFT_ASSERTS
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
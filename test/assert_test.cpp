@@ -22,6 +22,10 @@
 
 #include <catch2/catch.hpp>
 
+#include <cstddef>  // for std::size_t
+#include <string>
+#include <vector>
+
 // Test cases for assertions are mainly to check that the include header
 // compiles properly. Catch2 is not able to do death tests yet.
 
@@ -31,6 +35,83 @@ TEST_CASE("TestAssertion", "[common][assert]") {
   ASAP_ASSERT_VAL(true, 1);
 }
 
+TEST_CASE("TestAssertionLevels", "[common][assert]") {
+  int evaluated = 0;
+  auto check = [&evaluated]() {
+    ++evaluated;
+    return true;
+  };
+  ASAP_ASSERT(check());
+  ASAP_ASSERT_AUDIT(check());
+  ASAP_ASSUME(check());
+  static_cast<void>(check);
+#if ASAP_ASSERT_LEVEL >= ASAP_ASSERT_LEVEL_AUDIT
+  REQUIRE(evaluated == 3);
+#elif ASAP_ASSERT_LEVEL >= ASAP_ASSERT_LEVEL_DEFAULT
+  REQUIRE(evaluated == 2);
+#else
+  REQUIRE(evaluated <= 1);
+#endif
+}
+
+namespace {
+enum class Color : unsigned char { RED, GREEN };
+enum Plain { ONE = -1 };
+}  // namespace
+
+TEST_CASE("TestAssertionValues", "[common][assert]") {
+  std::string str("string");
+  int value = 42;
+  ASAP_ASSERT_VAL(true, value);
+  ASAP_ASSERT_VAL(true, 42U);
+  ASAP_ASSERT_VAL(true, static_cast<short>(-1));
+  ASAP_ASSERT_VAL(true, 4.2);
+  ASAP_ASSERT_VAL(true, 4.2F);
+  ASAP_ASSERT_VAL(true, 'c');
+  ASAP_ASSERT_VAL(true, false);
+  ASAP_ASSERT_VAL(true, "literal");
+  ASAP_ASSERT_VAL(true, str);
+  ASAP_ASSERT_VAL(true, str.c_str());
+  ASAP_ASSERT_VAL(true, &value);
+  ASAP_ASSERT_VAL(true, nullptr);
+  ASAP_ASSERT_VAL(true, Color::GREEN);
+  ASAP_ASSERT_VAL(true, ONE);
+  // Unused when the assertions are off or use assert()
+  static_cast<void>(value);
+}
+
+namespace {
+auto sum_checked(std::vector<int> const &values) -> long long {
+  long long sum = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    ASAP_ASSERT_VAL(values[i] >= 0, values[i]);
+    ASAP_ASSERT_VAL(i < values.size(), i);
+    sum += values[i];
+  }
+  return sum;
+}
+
+auto sum_unchecked(std::vector<int> const &values) -> long long {
+  long long sum = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+}  // namespace
+
+// The failure paths of the assertions are out of line: a loop full of them
+// should run about as fast as the same loop without them. Hidden, run with
+// `asap_common_test "[assert][benchmark]"`.
+TEST_CASE("TestAssertionBenchmark", "[.][assert][benchmark]") {
+  std::vector<int> values(1 << 16, 1);
+  REQUIRE(sum_checked(values) == sum_unchecked(values));
+#if defined(CATCH_CONFIG_ENABLE_BENCHMARKING)
+  BENCHMARK("loop with assertions") { return sum_checked(values); };
+  BENCHMARK("loop without assertions") { return sum_unchecked(values); };
+#endif
+}
+
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif // __clang__
@@ -0,0 +1,122 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/config.h>
+#include <common/crash_handler.h>
+
+#include <catch2/catch.hpp>
+
+#include <csignal>
+#include <string>
+
+#if defined(ASAP_POSIX)
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/// Run \a crash in a child process with the crash handler installed, and
+/// return the report it writes. \a sig is the signal that killed it.
+template <typename Function>
+auto crash_report(Function crash, int &sig) -> std::string {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  pid_t pid = ::fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    ::close(fds[0]);
+    asap::install_crash_handler(fds[1]);
+    crash();
+    ::_exit(0);
+  }
+  ::close(fds[1]);
+  std::string report;
+  char buffer[4096];
+  ssize_t got;
+  while ((got = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    report.append(buffer, static_cast<std::size_t>(got));
+  }
+  ::close(fds[0]);
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  sig = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+  return report;
+}
+
+void raise_segv() { std::raise(SIGSEGV); }
+
+void raise_fpe() { std::raise(SIGFPE); }
+
+}  // namespace
+
+TEST_CASE("CrashHandler / report", "[common][crash]") {
+  int sig = 0;
+  std::string report = crash_report(&raise_segv, sig);
+  REQUIRE(sig == SIGSEGV);
+  REQUIRE(report.find("Fatal signal") != std::string::npos);
+  REQUIRE(report.find("(SIGSEGV)") != std::string::npos);
+#if ASAP_USE_EXECINFO
+  REQUIRE(report.find("1: 0x") != std::string::npos);
+#endif
+#if defined(ASAP_LINUX)
+  REQUIRE(report.find("modules:\n") != std::string::npos);
+  REQUIRE(report.find("r-xp") != std::string::npos);
+#endif
+
+  report = crash_report(&raise_fpe, sig);
+  REQUIRE(sig == SIGFPE);
+  REQUIRE(report.find("(SIGFPE)") != std::string::npos);
+}
+
+// Sanitizers handle stack overflows themselves
+#if !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+namespace {
+// Recurse until the stack overflows; the result is never used
+auto overflow(int depth) -> int {
+  volatile char frame[4096];
+  frame[0] = static_cast<char>(depth);
+  return depth == -1 ? 0 : overflow(depth + 1) + frame[0];
+}
+
+void overflow_stack() { static_cast<void>(overflow(0)); }
+}  // namespace
+
+TEST_CASE("CrashHandler / stack overflow", "[common][crash]") {
+  int sig = 0;
+  std::string report = crash_report(&overflow_stack, sig);
+  REQUIRE(sig == SIGSEGV);
+  REQUIRE(report.find("(SIGSEGV)") != std::string::npos);
+}
+#endif
+
+TEST_CASE("CrashHandler / install", "[common][crash]") {
+  REQUIRE(asap::install_crash_stack());
+  REQUIRE(asap::install_crash_handler());
+  REQUIRE(asap::install_crash_handler(2));
+  asap::uninstall_crash_handler();
+}
+
+#endif  // ASAP_POSIX
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
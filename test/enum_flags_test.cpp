@@ -0,0 +1,98 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/enum_flags.h>
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+enum class Access : std::uint8_t { READ = 1, WRITE = 2, EXECUTE = 4 };
+ASAP_ENUM_FLAGS_OPERATORS(Access)
+
+enum class Wide : std::int64_t { LOW = 1, HIGH = INT64_MIN };
+
+using AccessFlags = asap::EnumFlags<Access>;
+
+// Everything but mutation folds at compile time
+constexpr AccessFlags none{};
+constexpr AccessFlags read_write = Access::READ | Access::WRITE;
+static_assert(none.none() && !none.any(), "");
+static_assert(read_write.any() && read_write.count() == 2, "");
+static_assert(read_write.all(Access::READ), "");
+static_assert(!read_write.all(Access::READ | Access::EXECUTE), "");
+static_assert(read_write.any(Access::READ | Access::EXECUTE), "");
+static_assert(read_write.none(Access::EXECUTE), "");
+static_assert((read_write & Access::WRITE) == Access::WRITE, "");
+static_assert((read_write ^ Access::READ) == Access::WRITE, "");
+static_assert((~read_write).value() == 0xFC, "");
+static_assert(*read_write.begin() == Access::READ, "");
+static_assert(AccessFlags::from_value(7).count() == 3, "");
+
+static_assert(sizeof(AccessFlags) == sizeof(Access), "");
+static_assert(std::is_same<AccessFlags::value_type, std::uint8_t>::value, "");
+static_assert(std::is_same<asap::EnumFlags<Wide>::value_type,
+                           std::uint64_t>::value,
+              "");
+static_assert(std::is_trivially_copyable<AccessFlags>::value, "");
+
+}  // namespace
+
+TEST_CASE("EnumFlags / set clear flip", "[common][flag][enum]") {
+  AccessFlags flags;
+  flags.set(Access::READ | Access::EXECUTE);
+  REQUIRE(flags.value() == 5);
+  flags.clear(Access::READ);
+  REQUIRE(flags == Access::EXECUTE);
+  flags.flip(Access::EXECUTE | Access::WRITE);
+  REQUIRE(flags == Access::WRITE);
+  flags |= Access::READ;
+  flags &= ~AccessFlags(Access::WRITE);
+  flags ^= Access::EXECUTE;
+  REQUIRE(flags == (Access::READ | Access::EXECUTE));
+  REQUIRE(static_cast<bool>(flags));
+  REQUIRE_FALSE(static_cast<bool>(AccessFlags()));
+}
+
+TEST_CASE("EnumFlags / iteration", "[common][flag][enum]") {
+  std::vector<Access> seen;
+  for (Access flag : Access::WRITE | Access::EXECUTE | Access::READ) {
+    seen.push_back(flag);
+  }
+  REQUIRE(seen ==
+          std::vector<Access>{Access::READ, Access::WRITE, Access::EXECUTE});
+
+  REQUIRE(AccessFlags().begin() == AccessFlags().end());
+
+  // The highest bit of a signed underlying type
+  asap::EnumFlags<Wide> wide = asap::EnumFlags<Wide>(Wide::HIGH) | Wide::LOW;
+  std::vector<Wide> bits(wide.begin(), wide.end());
+  REQUIRE(bits == std::vector<Wide>{Wide::LOW, Wide::HIGH});
+  REQUIRE(wide.count() == 2);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
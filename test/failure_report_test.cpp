@@ -0,0 +1,148 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/assert.h>
+#include <common/config.h>
+#include <common/crash_handler.h>
+#include <common/failure_report.h>
+
+#include <catch2/catch.hpp>
+
+#include <csignal>
+#include <cstdio>
+#include <string>
+
+#if defined(ASAP_POSIX)
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/// Run \a fail in a child process that writes its failure records to a pipe,
+/// and return them. The text reports go to /dev/null.
+template <typename Function>
+auto failure_records(Function fail) -> std::string {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+  pid_t pid = ::fork();
+  REQUIRE(pid >= 0);
+  if (pid == 0) {
+    ::close(fds[0]);
+    // Not the handler of the test framework, which would report a failure
+    std::signal(SIGABRT, SIG_DFL);
+    std::freopen("/dev/null", "w", stderr);
+    asap::set_failure_report_fd(fds[1]);
+    fail();
+    ::_exit(0);
+  }
+  ::close(fds[1]);
+  std::string records;
+  char buffer[4096];
+  ssize_t got;
+  while ((got = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+    records.append(buffer, static_cast<std::size_t>(got));
+  }
+  ::close(fds[0]);
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  return records;
+}
+
+#if ASAP_USE_ASSERTS
+void fail_assertion() {
+  asap::assert_fail("name == \"x\"", 42, "file.cpp", "void f()", "name: y\n");
+}
+
+void fail_non_utf8() {
+  // A valid sequence, stray bytes, an overlong form and a cut sequence
+  asap::assert_fail("ok", 1, "file.cpp", "h",
+                    "caf\xc3\xa9 \xff\xe9t\xc0\xaf \xe2\x82");
+}
+
+void fail_precondition() {
+  asap::assert_fail("p != nullptr", 7, "file.cpp", "g", nullptr, 1);
+}
+#endif  // ASAP_USE_ASSERTS
+
+void crash() {
+  asap::install_crash_handler(::open("/dev/null", O_WRONLY));
+  std::raise(SIGSEGV);
+}
+
+}  // namespace
+
+TEST_CASE("FailureReport / fd", "[common][assert][report]") {
+  REQUIRE(asap::failure_report_fd() < 0);
+  asap::set_failure_report_fd(5);
+  REQUIRE(asap::failure_report_fd() == 5);
+  asap::set_failure_report_fd(-2);
+  REQUIRE(asap::failure_report_fd() < 0);
+}
+
+#if ASAP_USE_ASSERTS
+TEST_CASE("FailureReport / assertion", "[common][assert][report]") {
+  std::string record = failure_records(&fail_assertion);
+  REQUIRE(record.find("{\"kind\":\"assertion\",") == 0);
+  REQUIRE(record.find("\n") == record.size() - 1);
+  REQUIRE(record.find("\"expression\":\"name == \\\"x\\\"\"") !=
+          std::string::npos);
+  REQUIRE(record.find("\"file\":\"file.cpp\",\"line\":42,") !=
+          std::string::npos);
+  REQUIRE(record.find("\"function\":\"void f()\"") != std::string::npos);
+  REQUIRE(record.find("\"value\":\"name: y\\u000a\"") != std::string::npos);
+  REQUIRE(record.find("\"signal\":null,\"address\":null") != std::string::npos);
+  REQUIRE(record.find("\"timestamp_ns\":") != std::string::npos);
+#if ASAP_USE_EXECINFO
+  REQUIRE(record.find("\"frames\":[\"0x") != std::string::npos);
+#endif
+#if defined(ASAP_LINUX)
+  REQUIRE(record.find("\"modules\":[{\"start\":\"0x") != std::string::npos);
+#endif
+}
+
+TEST_CASE("FailureReport / non UTF-8 value", "[common][assert][report]") {
+  std::string record = failure_records(&fail_non_utf8);
+  REQUIRE(record.find("\"value\":\"caf\xc3\xa9 \\ufffd\\ufffdt\\ufffd\\ufffd "
+                      "\\ufffd\\ufffd\"") != std::string::npos);
+}
+
+TEST_CASE("FailureReport / precondition", "[common][assert][report]") {
+  std::string record = failure_records(&fail_precondition);
+  REQUIRE(record.find("{\"kind\":\"precondition\",") == 0);
+  REQUIRE(record.find("\"value\":null") != std::string::npos);
+}
+#endif  // ASAP_USE_ASSERTS
+
+TEST_CASE("FailureReport / crash", "[common][crash][report]") {
+  std::string record = failure_records(&crash);
+  REQUIRE(record.find("{\"kind\":\"crash\",\"expression\":null,\"file\":null,"
+                      "\"line\":null,") == 0);
+  REQUIRE(record.find("\"signal\":" + std::to_string(SIGSEGV) +
+                      ",\"address\":\"0x") != std::string::npos);
+}
+
+#endif  // ASAP_POSIX
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -21,7 +21,10 @@
 #include <common/flag_ops.h>
 
 #include <catch2/catch.hpp>
+#include <atomic>
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 namespace asap {
 
@@ -93,6 +96,70 @@ TEST_CASE("Flag / Test", "[common][flag]") {
   REQUIRE(FlagTest(mask, mask));
 }
 
+TEST_CASE("Flag / Atomic", "[common][flag]") {
+  std::atomic<std::uint32_t> mask{0x100010};
+
+  REQUIRE(FlagSet(mask, 0x1001) == 0x100010);
+  REQUIRE(mask.load() == 0x101011);
+  REQUIRE(FlagClear(mask, 0x11, std::memory_order_release) == 0x101011);
+  REQUIRE(mask.load() == 0x101000);
+  REQUIRE(FlagFlip(mask, 0x1100, std::memory_order_relaxed) == 0x101000);
+  REQUIRE(mask.load() == 0x100100);
+  REQUIRE(FlagTest(mask, 0x100100));
+  REQUIRE_FALSE(FlagTest(mask, 0x1, std::memory_order_acquire));
+
+  std::atomic<std::uint8_t> small{0x81};
+  FlagClear(small, 0x80);
+  REQUIRE(small.load() == 0x01);
+}
+
+TEST_CASE("Flag / Atomic transition", "[common][flag]") {
+  const std::uint32_t OWNED = 0x1;
+  const std::uint32_t CLOSING = 0x2;
+  const std::uint32_t READY = 0x4;
+  std::atomic<std::uint32_t> state{READY};
+
+  REQUIRE(FlagSetIfClear(state, OWNED, CLOSING | OWNED));
+  REQUIRE(state.load() == (READY | OWNED));
+  REQUIRE_FALSE(FlagSetIfClear(state, OWNED, CLOSING | OWNED));
+
+  // Release: requires OWNED, clears it and READY, sets CLOSING
+  REQUIRE_FALSE(FlagTransition(state, CLOSING, 0u, 0u, OWNED));
+  REQUIRE(FlagTransition(state, OWNED, CLOSING, CLOSING, OWNED | READY,
+                         std::memory_order_acq_rel));
+  REQUIRE(state.load() == CLOSING);
+  REQUIRE_FALSE(FlagSetIfClear(state, OWNED, CLOSING,
+                               std::memory_order_acquire));
+}
+
+TEST_CASE("Flag / Atomic transition is exclusive", "[common][flag]") {
+  const std::uint64_t OWNED = 0x1;
+  std::atomic<std::uint64_t> state{0};
+  std::atomic<int> owners{0};
+  std::atomic<int> overlaps{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&state, &owners, &overlaps, t]() {
+      for (int i = 0; i < 10000; ++i) {
+        if (FlagSetIfClear(state, OWNED, OWNED, std::memory_order_acquire)) {
+          if (owners.fetch_add(1) != 0) {
+            ++overlaps;
+          }
+          owners.fetch_sub(1);
+          FlagClear(state, OWNED, std::memory_order_release);
+        }
+        // Unrelated bits change concurrently
+        FlagFlip(state, std::uint64_t(2) << t, std::memory_order_relaxed);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  REQUIRE(overlaps.load() == 0);
+  REQUIRE(state.load() == 0);
+}
+
 } // namespace asap
 
 #if defined(__clang__)
@@ -0,0 +1,99 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/config.h>
+#include <common/profiler.h>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdint>  // for int types
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(ASAP_POSIX) && ASAP_USE_EXECINFO
+
+namespace {
+// Keep the CPU busy for about \a ms milliseconds of CPU time
+auto burn(int ms) -> std::uint64_t {
+  std::uint64_t x = 0x12345678;
+  auto start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - start <
+         std::chrono::milliseconds(ms)) {
+    for (int i = 0; i < 10000; ++i) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+    }
+  }
+  return x;
+}
+}  // namespace
+
+TEST_CASE("Profiler / folded stacks", "[common][profiler]") {
+  REQUIRE(asap::start_profiler(1000));
+  REQUIRE_FALSE(asap::start_profiler(1000));
+  REQUIRE(burn(200) != 0);
+  asap::stop_profiler();
+
+  asap::profiler_statistics stats = asap::profiler_stats();
+  REQUIRE(stats.samples > 0);
+
+  std::string folded = asap::profiler_folded_stacks();
+  REQUIRE(!folded.empty());
+  // Each line is "frame;frame;...;frame count"
+  std::istringstream lines(folded);
+  std::string line;
+  std::uint64_t total = 0;
+  bool well_formed = true;
+  while (std::getline(lines, line)) {
+    std::size_t space = line.rfind(' ');
+    well_formed = well_formed && space != std::string::npos && space > 0;
+    total += std::stoull(line.substr(space + 1));
+  }
+  REQUIRE(well_formed);
+  REQUIRE(total == stats.samples);
+
+  // Drained
+  REQUIRE(asap::profiler_folded_stacks().empty());
+}
+
+TEST_CASE("Profiler / buffer reuse", "[common][profiler]") {
+  auto register_thread = []() {
+    std::thread thread([]() { asap::profiler_register_thread(); });
+    thread.join();
+    asap::profiler_folded_stacks();
+  };
+  register_thread();
+  std::uint64_t buffers = asap::profiler_stats().buffers;
+  // The buffer of each thread that exited is reused by the next one
+  for (int i = 0; i < 10; ++i) {
+    register_thread();
+  }
+  REQUIRE(asap::profiler_stats().buffers == buffers);
+}
+
+#endif  // ASAP_POSIX && ASAP_USE_EXECINFO
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
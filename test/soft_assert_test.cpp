@@ -0,0 +1,124 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/soft_assert.h>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <cstdint>  // for int types
+#include <cstring>  // for std::strcmp
+#include <thread>
+#include <vector>
+
+#if ASAP_SOFT_ASSERTS
+
+namespace {
+std::atomic<int> reported{0};
+std::atomic<std::uint64_t> last_suppressed{0};
+
+void count_report(asap::soft_assert_report const &report) {
+  ++reported;
+  last_suppressed = report.suppressed;
+}
+
+auto check_positive(int value) -> bool {
+  ASAP_ASSERT_SOFT(value > 0);
+  return value > 0;
+}
+
+auto check_even(int value) -> bool {
+  ASAP_ASSERT_SOFT(value % 2 == 0);
+  return value % 2 == 0;
+}
+
+auto find_site(char const *expr) -> asap::soft_assert_stats {
+  for (asap::soft_assert_stats const &stats : asap::soft_assert_snapshot()) {
+    if (std::strcmp(stats.expr, expr) == 0) {
+      return stats;
+    }
+  }
+  return {nullptr, nullptr, 0, nullptr, 0, 0};
+}
+}  // namespace
+
+TEST_CASE("SoftAssertion / rate limit", "[common][assert][soft]") {
+  asap::soft_assert_handler previous =
+      asap::set_soft_assert_handler(&count_report);
+  asap::set_soft_assert_rate_limit(3, 60000);
+  reported = 0;
+
+  int failed = 0;
+  for (int i = 0; i < 100; ++i) {
+    failed += check_positive(-i) ? 0 : 1;
+  }
+  REQUIRE(failed == 100);
+  REQUIRE(check_positive(1));
+  // The first 3 failures are reported, the next ones are within the interval
+  REQUIRE(reported == 3);
+
+  asap::soft_assert_stats stats = find_site("value > 0");
+  REQUIRE(stats.expr != nullptr);
+  REQUIRE(stats.hits == 100);
+  REQUIRE(stats.reports == 3);
+  REQUIRE(std::strcmp(stats.function, "") != 0);
+
+  // Without interval, every failure is reported again
+  asap::set_soft_assert_rate_limit(0, 0);
+  REQUIRE_FALSE(check_positive(0));
+  REQUIRE(reported == 4);
+  REQUIRE(last_suppressed == 97);
+
+  asap::set_soft_assert_rate_limit(10, 1000);
+  asap::set_soft_assert_handler(previous);
+}
+
+TEST_CASE("SoftAssertion / threads", "[common][assert][soft]") {
+  asap::soft_assert_handler previous =
+      asap::set_soft_assert_handler(&count_report);
+  asap::set_soft_assert_rate_limit(1, 60000);
+  reported = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([]() {
+      for (int i = 0; i < 10000; ++i) {
+        check_even(1);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  REQUIRE(reported == 1);
+  asap::soft_assert_stats stats = find_site("value % 2 == 0");
+  REQUIRE(stats.hits == 40000);
+  REQUIRE(stats.reports == 1);
+
+  asap::set_soft_assert_rate_limit(10, 1000);
+  asap::set_soft_assert_handler(previous);
+}
+
+#endif  // ASAP_SOFT_ASSERTS
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -0,0 +1,90 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/config.h>
+#include <common/stack_trace.h>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>  // for std::count
+#include <cstddef>    // for std::size_t
+#include <string>
+
+namespace {
+auto capture_here(std::size_t skip = 0) -> asap::stack_trace {
+  return asap::stack_trace::capture(skip);
+}
+}  // namespace
+
+#if ASAP_USE_EXECINFO
+
+TEST_CASE("StackTrace / capture", "[common][stack_trace]") {
+  asap::stack_trace first;
+  asap::stack_trace second;
+  REQUIRE(first.empty());
+  for (int i = 0; i < 2; ++i) {
+    (i == 0 ? first : second) = capture_here();
+  }
+  REQUIRE(!first.empty());
+  REQUIRE(first.size() <= asap::stack_trace::max_frames);
+  // Same call site, same trace
+  REQUIRE(first == second);
+  REQUIRE(first.hash() == second.hash());
+
+  asap::stack_trace shorter = capture_here(1);
+  REQUIRE(shorter != first);
+  if (first.size() < asap::stack_trace::max_frames) {
+    REQUIRE(shorter.size() == first.size() - 1);
+  }
+  // Without capture_here(), this function is the innermost frame, and the
+  // callers of this function are the same
+  REQUIRE(std::equal(shorter.begin() + 1, shorter.end(), first.begin() + 2));
+}
+
+TEST_CASE("StackTrace / symbolize", "[common][stack_trace]") {
+  asap::stack_trace trace = capture_here();
+  std::string text = trace.to_string();
+  REQUIRE(static_cast<std::size_t>(
+              std::count(text.begin(), text.end(), '\n')) == trace.size());
+  REQUIRE(text.find(" 0: ") == 0);
+  // Served from the cache the second time
+  for (std::size_t i = 0; i < trace.size(); ++i) {
+    REQUIRE(trace.symbol(i) == trace.symbol(i));
+  }
+  REQUIRE(trace.to_string() == text);
+}
+
+#endif  // ASAP_USE_EXECINFO
+
+// Cost of a capture and of the printing of a trace seen before. Hidden, run
+// with `asap_common_test "[stack_trace][benchmark]"`.
+TEST_CASE("StackTrace / benchmark", "[.][stack_trace][benchmark]") {
+#if defined(CATCH_CONFIG_ENABLE_BENCHMARKING)
+  BENCHMARK("capture") { return capture_here(); };
+  asap::stack_trace trace = capture_here();
+  trace.to_string();
+  BENCHMARK("to_string, cached") { return trace.to_string(); };
+#endif
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -0,0 +1,128 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+#include <common/unicode/byte_order.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using nowide::conv::bytes_to_utf;
+using nowide::utf::byte_order;
+using nowide::utf::encoding;
+
+namespace {
+
+template <typename CharType>
+auto to_bytes(std::basic_string<CharType> const &units, bool little_endian)
+    -> std::string {
+  std::string bytes;
+  for (CharType unit : units) {
+    auto value = static_cast<std::uint32_t>(unit);
+    for (std::size_t i = 0; i < sizeof(CharType); ++i) {
+      std::size_t shift = 8 * (little_endian ? i : sizeof(CharType) - 1 - i);
+      bytes.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+  }
+  return bytes;
+}
+
+const std::string hello = "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xf0\x9f\x98\x80";
+
+}  // namespace
+
+TEST_CASE("Unicode / byte order / iterator", "[common][unicode][byte_order]") {
+  using nowide::utf::byte_order_iterator;
+  using nowide::utf::utf_traits;
+
+  const char data[] = "\xD8\x3D\xDE\x00\x00\x41";
+  byte_order_iterator<char16_t, byte_order::big> first(data);
+  byte_order_iterator<char16_t, byte_order::big> last(data + 6);
+  REQUIRE(*first == 0xD83D);
+  REQUIRE(utf_traits<char16_t>::decode(first, last) == 0x1F600);
+  REQUIRE(utf_traits<char16_t>::decode(first, last) == 0x41);
+  REQUIRE(first == last);
+
+  byte_order_iterator<char32_t, byte_order::little> it(data);
+  REQUIRE(*it == 0x00DE3DD8);
+  REQUIRE(nowide::utf::load_unit<char32_t, byte_order::big>(data) ==
+          0xD83DDE00);
+}
+
+TEST_CASE("Unicode / byte order / bytes_to_utf",
+          "[common][unicode][byte_order]") {
+  std::u16string u16 = nowide::conv::utf_to_utf<char16_t>(hello);
+  std::u32string u32 = nowide::conv::utf_to_utf<char32_t>(hello);
+
+  for (bool le : {true, false}) {
+    std::string bytes = to_bytes(u16, le);
+    auto enc = le ? encoding::utf16le : encoding::utf16be;
+    REQUIRE(bytes_to_utf<char>(bytes.data(), bytes.size(), enc) == hello);
+    REQUIRE(bytes_to_utf<char16_t>(bytes.data(), bytes.size(), enc) == u16);
+
+    bytes = to_bytes(u32, le);
+    enc = le ? encoding::utf32le : encoding::utf32be;
+    REQUIRE(bytes_to_utf<char>(bytes.data(), bytes.size(), enc) == hello);
+    REQUIRE(bytes_to_utf<char32_t>(bytes.data(), bytes.size(), enc) == u32);
+  }
+  REQUIRE(bytes_to_utf<char16_t>(hello.data(), hello.size(),
+                                 encoding::utf8) == u16);
+}
+
+TEST_CASE("Unicode / byte order / block boundaries",
+          "[common][unicode][byte_order]") {
+  // Shift a surrogate pair over every position around the internal block
+  // boundaries.
+  for (std::size_t prefix = 250; prefix < 260; ++prefix) {
+    std::string text(prefix, 'x');
+    text += hello;
+    text += std::string(300, 'y');
+    std::u16string u16 = nowide::conv::utf_to_utf<char16_t>(text);
+    std::string bytes = to_bytes(u16, false);
+    REQUIRE(bytes_to_utf<char>(bytes.data(), bytes.size(),
+                               encoding::utf16be) == text);
+  }
+}
+
+TEST_CASE("Unicode / byte order / errors", "[common][unicode][byte_order]") {
+  using nowide::conv::conversion_error;
+
+  // Lone high surrogate at the end
+  REQUIRE_THROWS_AS(bytes_to_utf<char>("\x41\x00\x3D\xD8", 4,
+                                       encoding::utf16le),
+                    conversion_error);
+  // Lone low surrogate
+  REQUIRE_THROWS_AS(bytes_to_utf<char>("\x00\xDE\x41\x00", 4,
+                                       encoding::utf16le),
+                    conversion_error);
+  // Not a whole number of code units
+  REQUIRE_THROWS_AS(bytes_to_utf<char>("\x41\x00\x00", 3, encoding::utf32le),
+                    conversion_error);
+  // Out of range code point
+  REQUIRE_THROWS_AS(bytes_to_utf<char>("\x00\x11\x00\x00", 4,
+                                       encoding::utf32be),
+                    conversion_error);
+  REQUIRE_THROWS_AS(bytes_to_utf<char>("abc", 3, encoding::unknown),
+                    conversion_error);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
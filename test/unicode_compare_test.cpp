@@ -0,0 +1,92 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+#include <common/unicode/compare.h>
+#include <common/unicode/encoding_utf.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using nowide::conv::utf_to_utf;
+using nowide::utf::compare;
+
+TEST_CASE("Unicode / compare / cross encoding",
+          "[common][unicode][compare]") {
+  // Sorted in code point order
+  const std::string sorted[] = {
+      "",
+      "a",
+      "abcdefghijklmnopqrstuvwxyz",
+      "abcdefghijklmnopqrstuvwxyz0",
+      "abcdefghijklmnopqrstuvwxz",
+      "\xd7\xa9",
+      "\xef\xbd\x81",      // U+FF41
+      "\xf0\x9f\x98\x80",  // U+1F600
+      "\xf0\x9f\x98\x80z",
+  };
+  for (auto const &a : sorted) {
+    for (auto const &b : sorted) {
+      int expected = (&a < &b) ? -1 : ((&a > &b) ? 1 : 0);
+      std::u16string b16 = utf_to_utf<char16_t>(b);
+      std::u32string b32 = utf_to_utf<char32_t>(b);
+      REQUIRE(compare(a, b) == expected);
+      REQUIRE(compare(a, b16) == expected);
+      REQUIRE(compare(a, b32) == expected);
+      REQUIRE(compare(utf_to_utf<char16_t>(a), b16) == expected);
+      REQUIRE(compare(utf_to_utf<wchar_t>(a), b) == expected);
+      REQUIRE(nowide::utf::equal(a, b16) == (expected == 0));
+      REQUIRE(nowide::utf::equal(utf_to_utf<char16_t>(a), b16) ==
+              (expected == 0));
+    }
+  }
+}
+
+TEST_CASE("Unicode / compare / code point order",
+          "[common][unicode][compare]") {
+  // UTF-16 code unit order puts the surrogate pair first
+  std::u16string supplementary = u"\U0001F600";
+  std::u16string bmp = u"\uff41";
+  REQUIRE(supplementary < bmp);
+  REQUIRE(compare(supplementary, bmp) > 0);
+  REQUIRE(compare(bmp, std::string("\xf0\x9f\x98\x80")) < 0);
+}
+
+TEST_CASE("Unicode / compare / ill-formed", "[common][unicode][compare]") {
+  std::string bad = "ab\xff";
+  REQUIRE(compare(bad, std::u32string(U"ab\U0010FFFF")) > 0);
+  REQUIRE(compare(std::u16string(u"ab"), bad) < 0);
+  // Ill-formed sequences order by their code units, consistently with equal
+  REQUIRE(nowide::utf::equal(bad, bad));
+  REQUIRE(compare(bad, bad) == 0);
+  std::string other = "ab\xfe";
+  REQUIRE_FALSE(nowide::utf::equal(bad, other));
+  REQUIRE(compare(other, bad) < 0);
+  REQUIRE(compare(bad, other) > 0);
+  REQUIRE(compare(bad, std::string("ab\xff\xff")) < 0);
+  std::u16string lone = u"a";
+  lone += static_cast<char16_t>(0xD800);
+  REQUIRE(nowide::utf::equal(lone, lone));
+  REQUIRE(compare(lone, lone) == 0);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -0,0 +1,122 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/unicode/conversion_cache.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using nowide::conv::widen_cache;
+
+TEST_CASE("Unicode / conversion cache / hits and misses",
+          "[common][unicode][conversion_cache]") {
+  widen_cache cache(64, 4);
+  const std::string path = "C:\\Users\\\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d";
+
+  auto first = cache.convert(path);
+  REQUIRE(*first == nowide::conv::utf_to_utf<wchar_t>(path));
+  auto second = cache.convert(path.c_str());
+  // The very same string is shared
+  REQUIRE(second.get() == first.get());
+  auto other = cache.convert(path.data(), path.data() + 2);
+  REQUIRE(*other == L"C:");
+
+  auto stats = cache.stats();
+  REQUIRE(stats.hits == 1);
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.evictions == 0);
+  REQUIRE(cache.size() == 2);
+
+  cache.clear();
+  REQUIRE(cache.size() == 0);
+  REQUIRE(cache.stats().hits == 0);
+  // Still valid after being dropped from the cache
+  REQUIRE(*first == nowide::conv::utf_to_utf<wchar_t>(path));
+  REQUIRE(cache.convert(path).get() != first.get());
+}
+
+TEST_CASE("Unicode / conversion cache / eviction",
+          "[common][unicode][conversion_cache]") {
+  nowide::conv::narrow_cache cache(16, 1);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(*cache.convert(std::to_wstring(i)) == std::to_string(i));
+  }
+  REQUIRE(cache.size() == 16);
+  REQUIRE(cache.stats().evictions == 100 - 16);
+
+  // Entries used since the clock hand last passed are kept
+  cache.clear();
+  for (int i = 0; i < 16; ++i) {
+    cache.convert(std::to_wstring(i));
+  }
+  cache.convert(L"7");
+  cache.convert(L"new");
+  cache.convert(L"7");
+  REQUIRE(cache.stats().hits == 2);
+}
+
+TEST_CASE("Unicode / conversion cache / errors",
+          "[common][unicode][conversion_cache]") {
+  widen_cache cache;
+  REQUIRE_THROWS_AS(cache.convert("\xff"), nowide::conv::conversion_error);
+  REQUIRE_THROWS_AS(cache.convert("\xff"), nowide::conv::conversion_error);
+  REQUIRE(cache.size() == 0);
+  REQUIRE(cache.stats().misses == 2);
+}
+
+TEST_CASE("Unicode / conversion cache / threads",
+          "[common][unicode][conversion_cache]") {
+  widen_cache cache;
+  std::vector<std::string> keys;
+  for (int i = 0; i < 64; ++i) {
+    keys.push_back("/usr/share/\xe4\xbd\xa0" + std::to_string(i));
+  }
+  std::vector<std::thread> threads;
+  std::vector<int> failures(4, 0);
+  for (std::size_t t = 0; t < failures.size(); ++t) {
+    threads.emplace_back([&cache, &keys, &failures, t]() {
+      for (int round = 0; round < 100; ++round) {
+        for (auto const &key : keys) {
+          if (*cache.convert(key) != nowide::conv::utf_to_utf<wchar_t>(key)) {
+            ++failures[t];
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int count : failures) {
+    REQUIRE(count == 0);
+  }
+  auto stats = cache.stats();
+  REQUIRE(stats.hits + stats.misses == 4 * 100 * 64);
+  REQUIRE(stats.misses >= 64);
+  REQUIRE(cache.size() == 64);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -18,10 +18,21 @@
 #pragma clang diagnostic ignored "-Wundefined-func-template"
 #endif // __clang__
 
+#include <common/config.h>
 #include <common/unicode/convert.h>
 
 #include <catch2/catch.hpp>
 
+#include <cstring>  // for std::memcpy
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#if defined(ASAP_POSIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 TEST_CASE("Unicode / nowide / widen", "[common][unicode][nowide]") {
   const std::string hello = "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d";
   const std::wstring whello = L"\u05e9\u05dc\u05d5\u05dd";
@@ -78,6 +89,402 @@ TEST_CASE("Unicode / nowide / strings", "[common][unicode][nowide]") {
   REQUIRE(nowide::widen(wbuf, 3, "xy") == std::wstring(L"xy"));
 }
 
+TEST_CASE("Unicode / nowide / NUL terminated", "[common][unicode][nowide]") {
+  const std::string text =
+      "0123456\xd7\xa9\xd7\x9c\xe4\xbd\xa0\xf0\x9f\x98\x80"
+      "a longer run of ASCII text to cross a few words \xf0\x9f\x98\x80";
+  const std::wstring wtext = nowide::widen(text.data(), text.data() + 7) +
+                             nowide::widen(text.substr(7));
+  // Every start offset and length, so that sequences and terminators fall
+  // at every position relative to the word boundaries.
+  for (std::size_t offset = 0; offset < 8; ++offset) {
+    for (std::size_t length = 0; length <= text.size(); ++length) {
+      std::string padded = std::string(offset, 'x') + text.substr(0, length);
+      char const *source = padded.c_str() + offset;
+      std::wstring expected;
+      try {
+        expected = nowide::widen(source, source + length);
+      } catch (nowide::conv::conversion_error const &) {
+        REQUIRE_THROWS_AS(nowide::widen(source),
+                          nowide::conv::conversion_error);
+        continue;
+      }
+      REQUIRE(nowide::widen(source) == expected);
+      REQUIRE(nowide::narrow(expected.c_str()) == text.substr(0, length));
+
+      std::vector<wchar_t> buf(expected.size() + 1);
+      REQUIRE(nowide::widen(buf.data(), buf.size(), source) == buf.data());
+      REQUIRE(std::wstring(buf.data()) == expected);
+      if (!expected.empty()) {
+        REQUIRE(nowide::widen(buf.data(), buf.size() - 1, source) == nullptr);
+      }
+    }
+  }
+  REQUIRE(wtext == nowide::widen(text.c_str()));
+  REQUIRE_THROWS_AS(nowide::widen("abc\xff"), nowide::conv::conversion_error);
+  wchar_t buf[8];
+  REQUIRE(nowide::widen(buf, 8, "abc\xd7") == nullptr);
+  REQUIRE(nowide::widen(buf, 1, "") == buf);
+  REQUIRE(buf[0] == 0);
+}
+
+TEST_CASE("Unicode / nowide / utf16 and utf32", "[common][unicode][nowide]") {
+  const std::string hello =
+      "hello \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xe4\xbd\xa0\xe5\xa5\xbd "
+      "\xf0\x9f\x98\x80";
+  const std::u16string u16hello =
+      u"hello \u05e9\u05dc\u05d5\u05dd \u4f60\u597d \U0001F600";
+  const std::u32string u32hello =
+      U"hello \u05e9\u05dc\u05d5\u05dd \u4f60\u597d \U0001F600";
+
+  REQUIRE(nowide::widen_u16(hello) == u16hello);
+  REQUIRE(nowide::widen_u16(hello.c_str()) == u16hello);
+  REQUIRE(nowide::widen_u16(hello.data(), hello.data() + 5) == u"hello");
+  REQUIRE(nowide::widen_u32(hello) == u32hello);
+  REQUIRE(nowide::widen_u32(hello.c_str()) == u32hello);
+  REQUIRE(nowide::widen_u32(hello.data(), hello.data() + 5) == U"hello");
+
+  REQUIRE(nowide::narrow(u16hello) == hello);
+  REQUIRE(nowide::narrow(u16hello.c_str()) == hello);
+  REQUIRE(nowide::narrow(u16hello.data(), u16hello.data() + 5) == "hello");
+  REQUIRE(nowide::narrow(u32hello) == hello);
+  REQUIRE(nowide::narrow(u32hello.c_str()) == hello);
+  REQUIRE(nowide::narrow(u32hello.data(), u32hello.data() + 5) == "hello");
+
+  REQUIRE_THROWS_AS(nowide::widen_u16("\xed\xa0\x80"),
+                    nowide::conv::conversion_error);
+  REQUIRE_THROWS_AS(nowide::narrow(std::u16string(1, char16_t(0xD800))),
+                    nowide::conv::conversion_error);
+  REQUIRE_THROWS_AS(nowide::narrow(std::u32string(1, char32_t(0x110000))),
+                    nowide::conv::conversion_error);
+
+#if defined(__cpp_char8_t)
+  const std::u8string u8hello(hello.begin(), hello.end());
+  REQUIRE(nowide::narrow(u8hello) == hello);
+  REQUIRE(nowide::widen_u16(u8hello) == u16hello);
+  REQUIRE(nowide::widen_u32(u8hello) == u32hello);
+  REQUIRE(nowide::widen(u8hello) == nowide::widen(hello));
+#endif
+}
+
+TEST_CASE("Unicode / nowide / kernels", "[common][unicode][nowide]") {
+  // Long enough to span several conversion blocks, with every sequence length
+  // falling on every block boundary.
+  std::string text;
+  for (int i = 0; i < 700; ++i) {
+    text += "a\xd7\xa9\xe4\xbd\xa0\xf0\x9f\x98\x80\xef\xbf\xbd";
+  }
+  std::u32string u32 = nowide::widen_u32(text);
+  REQUIRE(u32.size() == 700 * 5);
+  std::u16string u16 = nowide::conv::utf_to_utf<char16_t>(u32);
+  REQUIRE(u16.size() == 700 * 6);
+  REQUIRE(nowide::widen_u16(text) == u16);
+  REQUIRE(nowide::narrow(u16) == text);
+  REQUIRE(nowide::narrow(u32) == text);
+  REQUIRE(nowide::conv::utf_to_utf<char32_t>(u16) == u32);
+
+  // Sequences rejected by the fast paths go through the full decoder
+  REQUIRE_THROWS_AS(nowide::widen_u16("\xc2\x41"),
+                    nowide::conv::conversion_error);
+  REQUIRE_THROWS_AS(nowide::widen_u16("\xe1\x80\x41"),
+                    nowide::conv::conversion_error);
+  REQUIRE_THROWS_AS(nowide::widen_u16(std::string("\xe0\x80\x80")),
+                    nowide::conv::conversion_error);
+  REQUIRE_THROWS_AS(nowide::widen_u16(std::string("\xef\xbf")),
+                    nowide::conv::conversion_error);
+}
+
+namespace {
+
+/// A sink handing out room from fixed size chunks, like an arena would.
+class chunk_sink {
+ public:
+  using char_type = char16_t;
+
+  auto prepare(std::size_t n) -> char16_t * {
+    if (chunks_.empty() || n > chunk_size - used_) {
+      chunks_.push_back(std::vector<char16_t>(chunk_size));
+      used_ = 0;
+    }
+    return chunks_.back().data() + used_;
+  }
+
+  void commit(char16_t *end) {
+    auto first = chunks_.back().data() + used_;
+    text_.append(first, end);
+    used_ += static_cast<std::size_t>(end - first);
+  }
+
+  std::u16string text_;
+
+ private:
+  static const std::size_t chunk_size = 4096;
+  std::vector<std::vector<char16_t>> chunks_;
+  std::size_t used_{0};
+};
+
+}  // namespace
+
+TEST_CASE("Unicode / nowide / sinks", "[common][unicode][nowide]") {
+  using nowide::conv::conversion_result;
+  using nowide::conv::utf_to_sink;
+
+  std::string text;
+  for (int i = 0; i < 500; ++i) {
+    text += "abc \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xf0\x9f\x98\x80 ";
+  }
+  const char *begin = text.data();
+  const char *end = begin + text.size();
+  const std::u16string u16 = nowide::conv::utf_to_utf<char16_t>(text);
+
+  SECTION("resizable containers") {
+    std::vector<char16_t> vec(2, u'>');
+    nowide::conv::resizable_sink<std::vector<char16_t>> sink(vec);
+    REQUIRE(utf_to_sink(begin, end, sink) == conversion_result::ok);
+    REQUIRE(std::u16string(vec.begin(), vec.end()) == u">>" + u16);
+
+    std::u16string str;
+    str.reserve(u16.size());
+    nowide::conv::resizable_sink<std::u16string> str_sink(str);
+    REQUIRE(utf_to_sink(begin, end, str_sink) == conversion_result::ok);
+    REQUIRE(str == u16);
+  }
+
+  SECTION("fixed buffers") {
+    std::vector<char16_t> buffer(u16.size());
+    nowide::conv::buffer_sink<char16_t> sink(buffer.data(),
+                                             buffer.data() + buffer.size());
+    REQUIRE(utf_to_sink(begin, end, sink) == conversion_result::ok);
+    REQUIRE(sink.position() == buffer.data() + buffer.size());
+    REQUIRE(std::u16string(buffer.begin(), buffer.end()) == u16);
+
+    // One unit short: everything but the last code point
+    nowide::conv::buffer_sink<char16_t> short_sink(
+        buffer.data(), buffer.data() + buffer.size() - 1);
+    REQUIRE(utf_to_sink(begin, end, short_sink) == conversion_result::no_room);
+    REQUIRE(short_sink.position() == buffer.data() + buffer.size() - 1);
+
+    // Exact size buffers through basic_convert
+    std::vector<char> narrow(text.size() + 1);
+    std::u16string::const_pointer wbegin = u16.data();
+    REQUIRE(nowide::basic_convert(narrow.data(), narrow.size(), wbegin,
+                                  wbegin + u16.size()) == narrow.data());
+    REQUIRE(std::string(narrow.data()) == text);
+    REQUIRE(nowide::basic_convert(narrow.data(), narrow.size() - 1, wbegin,
+                                  wbegin + u16.size()) == nullptr);
+  }
+
+  SECTION("output iterators and custom sinks") {
+    std::deque<char32_t> out;
+    using iterator = std::back_insert_iterator<std::deque<char32_t>>;
+    nowide::conv::output_iterator_sink<char32_t, iterator> sink(
+        std::back_inserter(out));
+    REQUIRE(utf_to_sink(begin, end, sink) == conversion_result::ok);
+    REQUIRE(std::u32string(out.begin(), out.end()) ==
+            nowide::conv::utf_to_utf<char32_t>(text));
+
+    chunk_sink chunks;
+    REQUIRE(utf_to_sink(begin, end, chunks) == conversion_result::ok);
+    REQUIRE(chunks.text_ == u16);
+  }
+
+  SECTION("errors") {
+    std::string bad = text + "\xff" + text;
+    std::u16string str;
+    nowide::conv::resizable_sink<std::u16string> sink(str);
+    REQUIRE(utf_to_sink(bad.data(), bad.data() + bad.size(), sink) ==
+            conversion_result::invalid);
+    // What comes before the error is converted
+    REQUIRE(str == u16);
+  }
+}
+
+namespace {
+
+int allocations = 0;
+
+/// Allocator counting the allocations made through it.
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() = default;
+  template <typename U>
+  explicit counting_allocator(counting_allocator<U> const & /*other*/) {}
+
+  auto allocate(std::size_t n) -> T * {
+    ++allocations;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T *p, std::size_t n) { std::allocator<T>().deallocate(p, n); }
+
+  auto operator==(counting_allocator const & /*other*/) const -> bool {
+    return true;
+  }
+  auto operator!=(counting_allocator const & /*other*/) const -> bool {
+    return false;
+  }
+};
+
+/// Number of allocations made by converting \a text to CharOut, and the
+/// capacity of the result.
+template <typename CharOut, typename CharIn>
+auto conversion_allocations(std::basic_string<CharIn> const &text,
+                            std::size_t &capacity) -> int {
+  allocations = 0;
+  auto result = nowide::conv::utf_to_utf<CharOut, CharIn,
+                                         std::char_traits<CharOut>,
+                                         counting_allocator<CharOut>>(
+      text.data(), text.data() + text.size());
+  capacity = result.capacity();
+  return allocations;
+}
+
+}  // namespace
+
+TEST_CASE("Unicode / nowide / allocations", "[common][unicode][nowide]") {
+  // The result is allocated once, for the worst case size of the input
+  std::string mixed;
+  while (mixed.size() < 100000) {
+    mixed += "abc \xd7\xa9\xd7\x9c \xe4\xbd\xa0 \xf0\x9f\x98\x80 ";
+  }
+  const std::string ascii(100, 'a');
+  const std::wstring wide = nowide::widen(mixed);
+  std::size_t capacity = 0;
+
+  REQUIRE(conversion_allocations<char>(ascii, capacity) == 1);
+  REQUIRE(capacity < 2 * ascii.size());
+  REQUIRE(conversion_allocations<char>(mixed, capacity) == 1);
+  REQUIRE(capacity < 2 * mixed.size());
+  REQUIRE(conversion_allocations<wchar_t>(mixed, capacity) == 1);
+  REQUIRE(capacity < 2 * mixed.size());
+  REQUIRE(conversion_allocations<char16_t>(mixed, capacity) == 1);
+  REQUIRE(conversion_allocations<char>(wide, capacity) == 1);
+}
+
+TEST_CASE("Unicode / nowide / same encoding", "[common][unicode][nowide]") {
+  std::string text;
+  for (int i = 0; i < 700; ++i) {
+    text += "plain ascii \xd7\xa9\xe4\xbd\xa0\xf0\x9f\x98\x80";
+  }
+  REQUIRE(nowide::conv::utf_to_utf<char>(text) == text);
+  std::u16string u16 = nowide::conv::utf_to_utf<char16_t>(text);
+  REQUIRE(nowide::conv::utf_to_utf<char16_t>(u16) == u16);
+  std::u32string u32 = nowide::conv::utf_to_utf<char32_t>(text);
+  REQUIRE(nowide::conv::utf_to_utf<char32_t>(u32) == u32);
+
+  // Errors anywhere, including across block boundaries, are still caught
+  for (std::size_t pos : {std::size_t(0), std::size_t(1023), std::size_t(1024),
+                          text.size() / 2, text.size() - 1}) {
+    std::string bad = text;
+    bad.insert(pos, "\xed\xa0\x80");
+    REQUIRE_THROWS_AS(nowide::conv::utf_to_utf<char>(bad),
+                      nowide::conv::conversion_error);
+    std::string truncated = text.substr(0, pos) + "\xf0\x9f\x98";
+    REQUIRE_THROWS_AS(nowide::conv::utf_to_utf<char>(truncated),
+                      nowide::conv::conversion_error);
+    std::u16string bad16 = u16;
+    bad16.insert(pos < u16.size() ? pos : u16.size(), 1, char16_t(0xDC00));
+    REQUIRE_THROWS_AS(nowide::conv::utf_to_utf<char16_t>(bad16),
+                      nowide::conv::conversion_error);
+  }
+}
+
+TEST_CASE("Unicode / nowide / NUL terminated chunks",
+          "[common][unicode][nowide]") {
+  // Sequences straddling the end of the chunks scanned for the terminator
+  const std::size_t chunk = nowide::conv::details::terminated_chunk_size;
+  for (std::size_t shift = 0; shift < 5; ++shift) {
+    const std::string text = std::string(chunk - shift, 'a') +
+                             "\xf0\x9f\x98\x80\xe4\xbd\xa0" +
+                             std::string(chunk, 'b') + "\xd7\xa9";
+    const std::wstring wtext = nowide::widen(text);
+
+    std::vector<wchar_t> wbuf(text.size() + 1);
+    REQUIRE(nowide::widen(wbuf.data(), wbuf.size(), text.c_str()) ==
+            wbuf.data());
+    REQUIRE(std::wstring(wbuf.data()) == wtext);
+
+    std::vector<char> buf(text.size() + 1);
+    REQUIRE(nowide::narrow(buf.data(), buf.size(), wtext.c_str()) ==
+            buf.data());
+    REQUIRE(std::string(buf.data()) == text);
+    const std::u16string u16 = nowide::widen_u16(text);
+    REQUIRE(nowide::basic_convert(buf.data(), buf.size(), u16.c_str()) ==
+            buf.data());
+    REQUIRE(std::string(buf.data()) == text);
+
+    // A sequence cut short at the end of a chunk is still an error
+    const std::string cut =
+        std::string(chunk - shift, 'a') + "\xf0\x9f" + std::string(chunk, 'b');
+    REQUIRE(nowide::widen(wbuf.data(), wbuf.size(), cut.c_str()) == nullptr);
+  }
+}
+
+#if defined(ASAP_POSIX)
+namespace {
+/// Convert \a text to UTF-8 with basic_convert(), from a copy ending with its
+/// terminator right before an inaccessible page.
+template <typename CharType>
+auto convert_before_guard_page(std::basic_string<CharType> const &text)
+    -> std::string {
+  auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  void *map = ::mmap(nullptr, 2 * page, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  REQUIRE(map != MAP_FAILED);
+  char *base = static_cast<char *>(map);
+  REQUIRE(::mprotect(base + page, page, PROT_NONE) == 0);
+  std::size_t bytes = (text.size() + 1) * sizeof(CharType);
+  auto *source = reinterpret_cast<CharType *>(base + page - bytes);
+  std::memcpy(source, text.c_str(), bytes);
+  char buffer[64];
+  char const *result = nowide::basic_convert(buffer, sizeof(buffer), source);
+  std::string converted = result != nullptr ? result : "<failed>";
+  ::munmap(map, 2 * page);
+  return converted;
+}
+}  // namespace
+
+TEST_CASE("Unicode / nowide / NUL terminated before a guard page",
+          "[common][unicode][nowide]") {
+  // Nothing past the word holding the terminator may be read, whatever its
+  // position in that word
+  const std::string text = "abcdefg";
+  for (std::size_t length = 0; length <= text.size(); ++length) {
+    const std::string expected = text.substr(0, length);
+    REQUIRE(convert_before_guard_page(expected) == expected);
+    REQUIRE(convert_before_guard_page(nowide::widen(expected)) == expected);
+    REQUIRE(convert_before_guard_page(nowide::widen_u16(expected)) ==
+            expected);
+    REQUIRE(convert_before_guard_page(nowide::widen_u32(expected)) ==
+            expected);
+  }
+}
+#endif  // ASAP_POSIX
+
+TEST_CASE("Unicode / nowide / unchecked", "[common][unicode][nowide]") {
+  const std::string hello =
+      "hello \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xe4\xbd\xa0\xe5\xa5\xbd "
+      "\xf0\x9f\x98\x80 and a long enough ASCII tail";
+  const std::wstring whello = nowide::widen(hello);
+
+  REQUIRE(nowide::widen_unchecked(hello) == whello);
+  REQUIRE(nowide::narrow_unchecked(whello) == hello);
+  REQUIRE(nowide::widen_unchecked(hello.data(), hello.data() + 6) ==
+          L"hello ");
+  REQUIRE(nowide::narrow_unchecked(whello.data(), whello.data()) == "");
+
+  using nowide::conv::utf_to_utf;
+  using nowide::conv::utf_to_utf_unchecked;
+  std::u16string u16 = utf_to_utf<char16_t>(hello);
+  std::u32string u32 = utf_to_utf<char32_t>(hello);
+  REQUIRE(utf_to_utf_unchecked<char16_t>(hello) == u16);
+  REQUIRE(utf_to_utf_unchecked<char32_t>(u16) == u32);
+  REQUIRE(utf_to_utf_unchecked<char16_t>(u32) == u16);
+  REQUIRE(utf_to_utf_unchecked<char>(u16) == hello);
+  REQUIRE(utf_to_utf_unchecked<char>(u32) == hello);
+}
+
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif // __clang__
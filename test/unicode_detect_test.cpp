@@ -0,0 +1,145 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+#include <common/unicode/detect.h>
+#include <common/unicode/encoding_utf.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using nowide::utf::detect_bom;
+using nowide::utf::detect_encoding;
+using nowide::utf::encoding;
+
+namespace {
+
+// Serialize the UTF-16 or UTF-32 form of the UTF-8 string \a text to bytes in
+// the requested byte order.
+template <typename CharType>
+auto to_bytes(std::string const &text, bool little_endian) -> std::string {
+  std::basic_string<CharType> units =
+      nowide::conv::utf_to_utf<CharType>(text);
+  std::string bytes;
+  for (CharType unit : units) {
+    auto value = static_cast<std::uint32_t>(unit);
+    for (std::size_t i = 0; i < sizeof(CharType); ++i) {
+      std::size_t shift = 8 * (little_endian ? i : sizeof(CharType) - 1 - i);
+      bytes.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+  }
+  return bytes;
+}
+
+const std::string sample_text =  // NOLINT
+    "Hello, \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d - "
+    "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 \xf0\x9f\x98\x80 world";
+
+}  // namespace
+
+TEST_CASE("Unicode / detect / bom", "[common][unicode][detect]") {
+  struct {
+    char const *bytes;
+    std::size_t size;
+    encoding type;
+    std::size_t bom_size;
+  } const cases[] = {
+      {"\xEF\xBB\xBFx", 4, encoding::utf8, 3},
+      {"\xFF\xFEx\0", 4, encoding::utf16le, 2},
+      {"\xFE\xFF\0x", 4, encoding::utf16be, 2},
+      {"\xFF\xFE\0\0", 4, encoding::utf32le, 4},
+      {"\0\0\xFE\xFF", 4, encoding::utf32be, 4},
+      {"abcd", 4, encoding::unknown, 0},
+      {"\xFF", 1, encoding::unknown, 0},
+  };
+  for (auto const &test : cases) {
+    auto result = detect_bom(test.bytes, test.size);
+    REQUIRE(result.type == test.type);
+    REQUIRE(result.bom_size == test.bom_size);
+    REQUIRE(result.confidence == (test.bom_size != 0 ? 100 : 0));
+    REQUIRE(detect_encoding(test.bytes, test.size).bom_size == test.bom_size);
+  }
+}
+
+TEST_CASE("Unicode / detect / utf8", "[common][unicode][detect]") {
+  auto result = detect_encoding(sample_text.data(), sample_text.size());
+  REQUIRE(result.type == encoding::utf8);
+  REQUIRE(result.confidence >= 90);
+
+  std::string ascii = "plain ASCII text is also UTF-8";
+  REQUIRE(detect_encoding(ascii.data(), ascii.size()).type == encoding::utf8);
+
+  // Sample cut in the middle of a multi-byte sequence
+  auto cut = sample_text.find('\xd7') + 1;
+  result = detect_encoding(sample_text.data(), sample_text.size(), cut);
+  REQUIRE(result.type == encoding::utf8);
+}
+
+TEST_CASE("Unicode / detect / utf16", "[common][unicode][detect]") {
+  std::string le = to_bytes<char16_t>(sample_text, true);
+  auto result = detect_encoding(le.data(), le.size());
+  REQUIRE(result.type == encoding::utf16le);
+  REQUIRE(result.bom_size == 0);
+  REQUIRE(result.confidence > 50);
+
+  std::string be = to_bytes<char16_t>(sample_text, false);
+  result = detect_encoding(be.data(), be.size());
+  REQUIRE(result.type == encoding::utf16be);
+  REQUIRE(result.confidence > 50);
+
+  // No zero bytes at all, and only well formed in one byte order
+  std::string cjk = to_bytes<char16_t>("\xe4\xbb\x98\xe4\xbd\xa0", true);
+  result = detect_encoding(cjk.data(), cjk.size());
+  REQUIRE(result.type == encoding::utf16le);
+  REQUIRE(result.confidence < 50);
+}
+
+TEST_CASE("Unicode / detect / utf32", "[common][unicode][detect]") {
+  std::string le = to_bytes<char32_t>(sample_text, true);
+  auto result = detect_encoding(le.data(), le.size());
+  REQUIRE(result.type == encoding::utf32le);
+  REQUIRE(result.confidence >= 90);
+
+  std::string be = to_bytes<char32_t>(sample_text, false);
+  result = detect_encoding(be.data(), be.size());
+  REQUIRE(result.type == encoding::utf32be);
+  REQUIRE(result.confidence >= 90);
+
+  // Bounded sample of a large input
+  std::string large;
+  for (int i = 0; i < 1000; ++i) {
+    large += le;
+  }
+  result = detect_encoding(large.data(), large.size(), 1001);
+  REQUIRE(result.type == encoding::utf32le);
+}
+
+TEST_CASE("Unicode / detect / unknown", "[common][unicode][detect]") {
+  const char binary[] = "\x00\xDC\x00\x00\xFF\x00\x00\x00\x41";
+  auto result = detect_encoding(binary, sizeof(binary) - 1);
+  REQUIRE(result.type == encoding::unknown);
+  REQUIRE(result.confidence == 0);
+
+  REQUIRE(detect_encoding("", 0).type == encoding::unknown);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
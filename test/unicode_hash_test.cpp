@@ -0,0 +1,97 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+#include <common/unicode/encoding_utf.h>
+#include <common/unicode/hash.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <unordered_map>
+
+using nowide::conv::utf_to_utf;
+using nowide::utf::code_point_equal;
+using nowide::utf::code_point_hash;
+using nowide::utf::hash_code_points;
+
+TEST_CASE("Unicode / hash / encoding independent", "[common][unicode][hash]") {
+  const std::string samples[] = {
+      "",
+      "a",
+      "plain ASCII key that is longer than a few words",
+      "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d",
+      "mixed \xd0\x9f\xd1\x80\xd0\xb8 \xe4\xbd\xa0\xe5\xa5\xbd "
+      "\xf0\x9f\x98\x80 text",
+  };
+  for (auto const &utf8 : samples) {
+    std::u16string utf16 = utf_to_utf<char16_t>(utf8);
+    std::u32string utf32 = utf_to_utf<char32_t>(utf8);
+    std::wstring wide = utf_to_utf<wchar_t>(utf8);
+    std::size_t h = hash_code_points(utf8);
+    REQUIRE(hash_code_points(utf16) == h);
+    REQUIRE(hash_code_points(utf32) == h);
+    REQUIRE(hash_code_points(wide) == h);
+    REQUIRE(code_point_hash{}(utf8.c_str()) == h);
+    REQUIRE(code_point_hash{}(utf16) == h);
+
+    REQUIRE(code_point_equal{}(utf8, utf16));
+    REQUIRE(code_point_equal{}(utf32, utf8));
+    REQUIRE(code_point_equal{}(wide, utf8.c_str()));
+  }
+  REQUIRE(hash_code_points(std::string("ab")) !=
+          hash_code_points(std::string("ba")));
+}
+
+TEST_CASE("Unicode / hash / equality", "[common][unicode][hash]") {
+  code_point_equal equal;
+  REQUIRE(equal(std::string("abc"), u"abc"));
+  REQUIRE_FALSE(equal(std::string("abc"), u"abcd"));
+  REQUIRE_FALSE(equal(std::string("abcd"), U"abc"));
+  REQUIRE_FALSE(equal(std::string("\xd7\xa9"), u"\u05ea"));
+  // Ill-formed input is equal to the same code units, and hashes alike
+  REQUIRE(equal(std::string("\xff"), std::string("\xff")));
+  REQUIRE_FALSE(equal(std::string("\xff"), std::string("\xfe")));
+  std::u16string lone(1, static_cast<char16_t>(0xD800));
+  std::u32string lone32(1, static_cast<char32_t>(0xD800));
+  REQUIRE(equal(lone, lone32));
+  REQUIRE(code_point_hash{}(lone) == code_point_hash{}(lone32));
+}
+
+TEST_CASE("Unicode / hash / unordered_map", "[common][unicode][hash]") {
+  std::unordered_map<std::string, int, code_point_hash, code_point_equal> map;
+  map["\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d"] = 1;
+  map["world"] = 2;
+  REQUIRE(map.at("world") == 2);
+  REQUIRE(map.count("\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d") == 1);
+  // A malformed key is stored once, and found
+  map["bad\xff"] = 3;
+  map["bad\xff"] = 4;
+  REQUIRE(map.size() == 3);
+  REQUIRE(map.at("bad\xff") == 4);
+  REQUIRE(map.count("bad\xfe") == 0);
+#if defined(__cpp_lib_generic_unordered_lookup)
+  REQUIRE(map.find(std::u16string(u"\u05e9\u05dc\u05d5\u05dd"))->second == 1);
+  REQUIRE(map.find(std::u32string(U"world"))->second == 2);
+#endif
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
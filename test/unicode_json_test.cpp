@@ -0,0 +1,84 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+#include <common/unicode/json.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using nowide::conv::conversion_error;
+using nowide::json::escape;
+using nowide::json::escape_mode;
+using nowide::json::unescape;
+
+TEST_CASE("Unicode / json / escape", "[common][unicode][json]") {
+  REQUIRE(escape("") == "");
+  REQUIRE(escape("plain text that spans a few words") ==
+          "plain text that spans a few words");
+  REQUIRE(escape("say \"hi\"\\\n") == "say \\\"hi\\\"\\\\\\n");
+  REQUIRE(escape(std::string("\b\f\r\t\x01\x1f\0", 7)) ==
+          "\\b\\f\\r\\t\\u0001\\u001f\\u0000");
+  // Non ASCII is kept as UTF-8 except for the JavaScript line terminators
+  REQUIRE(escape("\xd7\xa9 \xe2\x80\xa8 \xe2\x80\xa9") ==
+          "\xd7\xa9 \\u2028 \\u2029");
+  // Special characters right after a long clean run
+  REQUIRE(escape("0123456789abcdef0123456789abcdef\"") ==
+          "0123456789abcdef0123456789abcdef\\\"");
+}
+
+TEST_CASE("Unicode / json / escape ascii", "[common][unicode][json]") {
+  REQUIRE(escape("a\xd7\xa9\xf0\x9f\x98\x80z", escape_mode::ascii) ==
+          "a\\u05e9\\ud83d\\ude00z");
+  REQUIRE_THROWS_AS(escape("bad \xff", escape_mode::ascii), conversion_error);
+  REQUIRE_THROWS_AS(escape("cut \xd7"), conversion_error);
+}
+
+TEST_CASE("Unicode / json / unescape", "[common][unicode][json]") {
+  REQUIRE(unescape("") == "");
+  REQUIRE(unescape("no escapes \xd7\xa9") == "no escapes \xd7\xa9");
+  REQUIRE(unescape("\\\"\\\\\\/\\b\\f\\n\\r\\t") == "\"\\/\b\f\n\r\t");
+  REQUIRE(unescape("\\u05E9\\u05e9") == "\xd7\xa9\xd7\xa9");
+  REQUIRE(unescape("[\\ud83d\\ude00]") == "[\xf0\x9f\x98\x80]");
+  REQUIRE(unescape("\\u0000") == std::string(1, '\0'));
+
+  REQUIRE_THROWS_AS(unescape("trailing \\"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\x41"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\u12"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\u12g4"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\ud83d"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\ud83dx\\ude00"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\ud83d\\u0041"), conversion_error);
+  REQUIRE_THROWS_AS(unescape("\\ude00"), conversion_error);
+}
+
+TEST_CASE("Unicode / json / round trip", "[common][unicode][json]") {
+  std::string text;
+  for (int i = 0; i < 0x80; ++i) {
+    text.push_back(static_cast<char>(i));
+  }
+  text += "\xd7\xa9\xd7\x9c\xe2\x80\xa8\xf0\x9f\x98\x80";
+  REQUIRE(unescape(escape(text)) == text);
+  REQUIRE(unescape(escape(text, escape_mode::ascii)) == text);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
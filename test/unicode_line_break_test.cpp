@@ -0,0 +1,185 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/unicode/line_break.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using nowide::utf::line_break_class;
+using nowide::utf::line_break_class_of;
+using nowide::utf::line_break_iterator;
+
+namespace {
+
+/// Split \a text at every break opportunity; mandatory breaks are marked
+/// with a trailing '|'.
+auto segments(std::string const &text) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  line_break_iterator breaks(text.data(), text.data() + text.size());
+  char const *start = text.data();
+  while (breaks.next()) {
+    result.emplace_back(start, breaks.position());
+    if (breaks.mandatory()) {
+      result.back() += '|';
+    }
+    start = breaks.position();
+  }
+  return result;
+}
+
+using list = std::vector<std::string>;
+
+}  // namespace
+
+TEST_CASE("Unicode / line break / classes",
+          "[common][unicode][line_break]") {
+  REQUIRE(line_break_class_of(' ') == line_break_class::sp);
+  REQUIRE(line_break_class_of('a') == line_break_class::al);
+  REQUIRE(line_break_class_of('7') == line_break_class::nu);
+  REQUIRE(line_break_class_of('(') == line_break_class::op);
+  REQUIRE(line_break_class_of(0x85) == line_break_class::nl);
+  REQUIRE(line_break_class_of(0xA0) == line_break_class::gl);
+  REQUIRE(line_break_class_of(0xE9) == line_break_class::al);
+  REQUIRE(line_break_class_of(0x301) == line_break_class::cm);
+  REQUIRE(line_break_class_of(0x5D0) == line_break_class::hl);
+  REQUIRE(line_break_class_of(0x200B) == line_break_class::zw);
+  REQUIRE(line_break_class_of(0x20AC) == line_break_class::pr);
+  REQUIRE(line_break_class_of(0x3002) == line_break_class::cl);
+  REQUIRE(line_break_class_of(0x4E00) == line_break_class::id);
+  REQUIRE(line_break_class_of(0x9FFF) == line_break_class::id);
+  REQUIRE(line_break_class_of(0xA4D0) == line_break_class::al);
+  REQUIRE(line_break_class_of(0x10000) == line_break_class::al);
+  REQUIRE(line_break_class_of(0x1F1E6) == line_break_class::ri);
+  REQUIRE(line_break_class_of(0x1F466) == line_break_class::eb);
+  REQUIRE(line_break_class_of(0x1F3FB) == line_break_class::em);
+  REQUIRE(line_break_class_of(0x1F600) == line_break_class::id);
+  REQUIRE(line_break_class_of(0xE0100) == line_break_class::cm);
+  REQUIRE(line_break_class_of(0x10FFFF) == line_break_class::al);
+}
+
+TEST_CASE("Unicode / line break / latin text",
+          "[common][unicode][line_break]") {
+  REQUIRE(segments("").empty());
+  REQUIRE(segments("word") == list{"word|"});
+  REQUIRE(segments("Hello, world! This is a test.") ==
+          list{"Hello, ", "world! ", "This ", "is ", "a ", "test.|"});
+  REQUIRE(segments("well-known 10-20") == list{"well-", "known ", "10-20|"});
+  REQUIRE(segments("(see: x)  next") == list{"(see: ", "x)  ", "next|"});
+  REQUIRE(segments("say \"hello there\" now") ==
+          list{"say ", "\"hello ", "there\" ", "now|"});
+  REQUIRE(segments("http://example.com/a") ==
+          list{"http://", "example.com/", "a|"});
+}
+
+TEST_CASE("Unicode / line break / mandatory breaks",
+          "[common][unicode][line_break]") {
+  REQUIRE(segments("a\nb") == list{"a\n|", "b|"});
+  REQUIRE(segments("a\r\nb\rc") == list{"a\r\n|", "b\r|", "c|"});
+  REQUIRE(segments("a \n\nb\n") == list{"a \n|", "\n|", "b\n|"});
+  // U+2028 LINE SEPARATOR
+  REQUIRE(segments("a\xe2\x80\xa8" "b") == list{"a\xe2\x80\xa8|", "b|"});
+}
+
+TEST_CASE("Unicode / line break / numbers",
+          "[common][unicode][line_break]") {
+  REQUIRE(segments("$100.00 (50%) 1,000 items") ==
+          list{"$100.00 ", "(50%) ", "1,000 ", "items|"});
+  REQUIRE(segments("-5 +3") == list{"-5 ", "+3|"});
+  // U+20AC EURO SIGN
+  REQUIRE(segments("\xe2\x82\xac" "12 x") == list{"\xe2\x82\xac" "12 ", "x|"});
+}
+
+TEST_CASE("Unicode / line break / non breaking",
+          "[common][unicode][line_break]") {
+  // U+00A0 NO-BREAK SPACE, U+2060 WORD JOINER
+  REQUIRE(segments("a\xc2\xa0" "b c") == list{"a\xc2\xa0" "b ", "c|"});
+  REQUIRE(segments("a-\xe2\x81\xa0" "b") == list{"a-\xe2\x81\xa0" "b|"});
+  // U+200B ZERO WIDTH SPACE
+  REQUIRE(segments("ab\xe2\x80\x8b" "cd") == list{"ab\xe2\x80\x8b", "cd|"});
+  // U+0301 COMBINING ACUTE ACCENT sticks to its base, unless it is a space
+  REQUIRE(segments("e\xcc\x81 x") == list{"e\xcc\x81 ", "x|"});
+  REQUIRE(segments("a \xcc\x81" "b") == list{"a ", "\xcc\x81" "b|"});
+}
+
+TEST_CASE("Unicode / line break / ideographs",
+          "[common][unicode][line_break]") {
+  // U+4F60 U+597D U+3002 U+4E16: no break before the ideographic full stop
+  REQUIRE(segments("\xe4\xbd\xa0\xe5\xa5\xbd\xe3\x80\x82\xe4\xb8\x96") ==
+          list{"\xe4\xbd\xa0", "\xe5\xa5\xbd\xe3\x80\x82", "\xe4\xb8\x96|"});
+  // U+300C LEFT CORNER BRACKET
+  REQUIRE(segments("\xe4\xbd\xa0\xe3\x80\x8c\xe5\xa5\xbd") ==
+          list{"\xe4\xbd\xa0", "\xe3\x80\x8c\xe5\xa5\xbd|"});
+  // Mixed with latin text
+  REQUIRE(segments("abc\xe4\xbd\xa0" "def") ==
+          list{"abc", "\xe4\xbd\xa0", "def|"});
+}
+
+TEST_CASE("Unicode / line break / emoji", "[common][unicode][line_break]") {
+  // Regional indicator pairs: FR DE
+  REQUIRE(segments("\xf0\x9f\x87\xab\xf0\x9f\x87\xb7\xf0\x9f\x87\xa9\xf0\x9f"
+                   "\x87\xaa") ==
+          list{"\xf0\x9f\x87\xab\xf0\x9f\x87\xb7",
+               "\xf0\x9f\x87\xa9\xf0\x9f\x87\xaa|"});
+  // U+1F466 BOY + U+1F3FB skin tone, then U+1F468 ZWJ U+1F469
+  REQUIRE(segments("\xf0\x9f\x91\xa6\xf0\x9f\x8f\xbb\xf0\x9f\x91\xa8\xe2\x80"
+                   "\x8d\xf0\x9f\x91\xa9") ==
+          list{"\xf0\x9f\x91\xa6\xf0\x9f\x8f\xbb",
+               "\xf0\x9f\x91\xa8\xe2\x80\x8d\xf0\x9f\x91\xa9|"});
+}
+
+TEST_CASE("Unicode / line break / hebrew and ill-formed",
+          "[common][unicode][line_break]") {
+  // U+05E9 U+05DC - U+05DD: no break after a hyphen following a Hebrew letter
+  REQUIRE(segments("\xd7\xa9\xd7\x9c-\xd7\x9d x") ==
+          list{"\xd7\xa9\xd7\x9c-\xd7\x9d ", "x|"});
+  // Ill-formed sequences are alphabetic
+  REQUIRE(segments("a\xff" "b \xe4\xbd") == list{"a\xff" "b ", "\xe4\xbd|"});
+}
+
+TEST_CASE("Unicode / line break / long text",
+          "[common][unicode][line_break]") {
+  std::string text;
+  std::size_t words = 0;
+  while (text.size() < (1U << 20)) {
+    text += "Lorem ipsum dolor sit amet, consectetur adipiscing elit. ";
+    text += "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xe4\xbd\xa0\xe5\xa5\xbd ";
+    words += 8 + 1 + 2;
+  }
+  std::size_t count = 0;
+  line_break_iterator breaks(text.data(), text.data() + text.size());
+  char const *last = text.data();
+  bool increasing = true;
+  while (breaks.next()) {
+    increasing = increasing && breaks.position() > last;
+    last = breaks.position();
+    ++count;
+  }
+  REQUIRE(increasing);
+  REQUIRE(last == text.data() + text.size());
+  REQUIRE(count == words);
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
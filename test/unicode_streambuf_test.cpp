@@ -0,0 +1,146 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+#include <common/unicode/streambuf.h>
+
+#include <catch2/catch.hpp>
+
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+using nowide::transcoding_streambuf;
+
+namespace {
+
+const std::string hello =
+    "hello \xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xe4\xbd\xa0\xe5\xa5\xbd "
+    "\xf0\x9f\x98\x80";
+
+auto long_text() -> std::string {
+  // Not a multiple of any sequence length, so that sequences fall on every
+  // block boundary
+  std::string text;
+  while (text.size() < 5 * transcoding_streambuf::block_size) {
+    text += hello;
+    text += 'x';
+  }
+  return text;
+}
+
+}  // namespace
+
+TEST_CASE("Unicode / streambuf / write", "[common][unicode][streambuf]") {
+  const std::string text = long_text();
+  const std::wstring wtext = nowide::conv::utf_to_utf<wchar_t>(text);
+
+  std::stringbuf device;
+  {
+    transcoding_streambuf buf(&device);
+    std::wostream out(&buf);
+    // Write in small uneven pieces
+    for (std::size_t i = 0; i < wtext.size(); i += 7) {
+      out << wtext.substr(i, 7);
+    }
+    out.flush();
+    REQUIRE(out.good());
+    REQUIRE(device.str() == text);
+    out << L"!";
+  }
+  // The destructor converts what is left
+  REQUIRE(device.str() == text + "!");
+}
+
+TEST_CASE("Unicode / streambuf / split sequences",
+          "[common][unicode][streambuf]") {
+  // UTF-8 in, UTF-16 out, written one code unit at a time
+  std::basic_stringbuf<char16_t> device;
+  nowide::basic_transcoding_streambuf<char16_t, char> buf(&device);
+  for (char c : hello) {
+    buf.sputc(c);
+    REQUIRE(buf.pubsync() == 0);
+  }
+  REQUIRE(device.str() == nowide::conv::utf_to_utf<char16_t>(hello));
+}
+
+TEST_CASE("Unicode / streambuf / read", "[common][unicode][streambuf]") {
+  const std::string text = long_text();
+
+  std::stringbuf device(text);
+  transcoding_streambuf buf(&device);
+  std::wistream in(&buf);
+  std::wstring wtext((std::istreambuf_iterator<wchar_t>(in)),
+                     std::istreambuf_iterator<wchar_t>());
+  REQUIRE(wtext == nowide::conv::utf_to_utf<wchar_t>(text));
+
+  // UTF-16 to UTF-32
+  std::u16string u16 = nowide::conv::utf_to_utf<char16_t>(text);
+  std::basic_stringbuf<char16_t> device16(u16);
+  nowide::basic_transcoding_streambuf<char16_t, char32_t> buf32(&device16);
+  std::u32string u32(text.size(), U'\0');
+  u32.resize(static_cast<std::size_t>(
+      buf32.sgetn(&u32[0], static_cast<std::streamsize>(u32.size()))));
+  REQUIRE(u32 == nowide::conv::utf_to_utf<char32_t>(text));
+}
+
+TEST_CASE("Unicode / streambuf / errors", "[common][unicode][streambuf]") {
+  using nowide::conv::conversion_error;
+
+  SECTION("ill-formed input when reading") {
+    std::stringbuf device("abc\xff" "def");
+    transcoding_streambuf buf(&device);
+    // The text before the error is read first
+    REQUIRE(buf.sgetc() == L'a');
+    REQUIRE(buf.in_avail() == 3);
+    buf.sbumpc();
+    buf.sbumpc();
+    buf.sbumpc();
+    REQUIRE_THROWS_AS(buf.sgetc(), conversion_error);
+
+    std::stringbuf device2("abc\xff");
+    transcoding_streambuf buf2(&device2);
+    std::wistream in(&buf2);
+    std::wstring word;
+    in >> word;
+    REQUIRE(in.bad());
+  }
+
+  SECTION("truncated input when reading") {
+    std::stringbuf device("\xe4\xbd");
+    transcoding_streambuf buf(&device);
+    REQUIRE_THROWS_AS(buf.sgetc(), conversion_error);
+  }
+
+  SECTION("ill-formed input when writing") {
+    std::stringbuf device;
+    transcoding_streambuf buf(&device);
+    std::wostream out(&buf);
+    out << L"abc" << static_cast<wchar_t>(0xD800) << L"x";
+    out.flush();
+    REQUIRE(out.bad());
+    REQUIRE(device.str() == "abc");
+  }
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -0,0 +1,115 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/unicode/truncate.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using nowide::utf::truncate_mode;
+
+namespace {
+
+template <typename CharType>
+auto truncated(std::basic_string<CharType> str, std::size_t max_units,
+               truncate_mode mode = truncate_mode::whole_code_point)
+    -> std::basic_string<CharType> {
+  nowide::utf::truncate(str, max_units, mode);
+  return str;
+}
+
+}  // namespace
+
+TEST_CASE("Unicode / truncate / code points", "[common][unicode][truncate]") {
+  // a, U+05E9 (2 bytes), U+4F60 (3 bytes), U+1F600 (4 bytes)
+  const std::string text = "a\xd7\xa9\xe4\xbd\xa0\xf0\x9f\x98\x80";
+  REQUIRE(truncated(text, 100) == text);
+  REQUIRE(truncated(text, text.size()) == text);
+  REQUIRE(truncated(text, 0).empty());
+  REQUIRE(truncated(text, 1) == "a");
+  REQUIRE(truncated(text, 2) == "a");
+  REQUIRE(truncated(text, 3) == "a\xd7\xa9");
+  REQUIRE(truncated(text, 4) == "a\xd7\xa9");
+  REQUIRE(truncated(text, 5) == "a\xd7\xa9");
+  REQUIRE(truncated(text, 6) == "a\xd7\xa9\xe4\xbd\xa0");
+  REQUIRE(truncated(text, 9) == "a\xd7\xa9\xe4\xbd\xa0");
+
+  const std::u16string u16 = u"a\u4f60\U0001F600b";
+  REQUIRE(truncated(u16, 2) == u"a\u4f60");
+  REQUIRE(truncated(u16, 3) == u"a\u4f60");
+  REQUIRE(truncated(u16, 4) == u"a\u4f60\U0001F600");
+
+  const std::u32string u32 = U"a\u4f60\U0001F600b";
+  REQUIRE(truncated(u32, 3) == U"a\u4f60\U0001F600");
+
+  // The range form only returns the new end
+  char const *end = nowide::utf::truncate(text.data(),
+                                          text.data() + text.size(), 8);
+  REQUIRE(end == text.data() + 6);
+}
+
+TEST_CASE("Unicode / truncate / ill-formed", "[common][unicode][truncate]") {
+  // Stray continuation bytes are cut as is
+  REQUIRE(truncated(std::string("ab\x80\x80\x80\x80\x80"), 5) ==
+          "ab\x80\x80\x80");
+  // A sequence shorter than announced is not a reason to move the cut
+  REQUIRE(truncated(std::string("a\xe4\xbd" "bc"), 4) == "a\xe4\xbd" "b");
+  // Lone low surrogate
+  REQUIRE(truncated(std::u16string{u'a', char16_t(0xDC00), char16_t(0xDC00)},
+                    2) == std::u16string{u'a', char16_t(0xDC00)});
+}
+
+TEST_CASE("Unicode / truncate / graphemes", "[common][unicode][truncate]") {
+  const auto grapheme = truncate_mode::grapheme;
+  // e + U+0301 COMBINING ACUTE ACCENT + U+0302
+  const std::string accents = "xe\xcc\x81\xcc\x82y";
+  REQUIRE(truncated(accents, 3) == "xe");
+  REQUIRE(truncated(accents, 3, grapheme) == "x");
+  REQUIRE(truncated(accents, 5, grapheme) == "x");
+  REQUIRE(truncated(accents, 6, grapheme) == "xe\xcc\x81\xcc\x82");
+
+  // U+1F468 ZWJ U+1F469, with a skin tone modifier U+1F3FB on the first
+  const std::string family =
+      "a\xf0\x9f\x91\xa8\xf0\x9f\x8f\xbb\xe2\x80\x8d\xf0\x9f\x91\xa9";
+  REQUIRE(truncated(family, 5) == "a\xf0\x9f\x91\xa8");
+  REQUIRE(truncated(family, 5, grapheme) == "a");
+  REQUIRE(truncated(family, 12, grapheme) == "a");
+  REQUIRE(truncated(family, 15, grapheme) == "a");
+  REQUIRE(truncated(family, 16, grapheme) == family);
+
+  // Regional indicator pairs FR DE are not split
+  const std::u32string flags = U"\U0001F1EB\U0001F1F7\U0001F1E9\U0001F1EA";
+  REQUIRE(truncated(flags, 1, grapheme).empty());
+  REQUIRE(truncated(flags, 2, grapheme) == U"\U0001F1EB\U0001F1F7");
+  REQUIRE(truncated(flags, 3, grapheme) == U"\U0001F1EB\U0001F1F7");
+
+  // CR LF and conjoining jamo U+1100 U+1161 U+11A8
+  REQUIRE(truncated(std::u16string(u"ab\r\n"), 3, grapheme) == u"ab");
+  REQUIRE(truncated(std::u16string(u"a\u1100\u1161\u11a8"), 3, grapheme) ==
+          u"a");
+  // Controls do not attach to what precedes them
+  REQUIRE(truncated(std::string("ab\x01\x02"), 3, grapheme) == "ab\x01");
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__
@@ -0,0 +1,199 @@
+//        Copyright The Authors 2018.
+//    Distributed under the 3-Clause BSD License.
+//    (See accompanying file LICENSE or copy at
+//   https://opensource.org/licenses/BSD-3-Clause)
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+// Catch2 uses a lot of macro names that will make clang go crazy
+#if (__clang_major__ >= 13) && !defined(__APPLE__)
+#pragma clang diagnostic ignored "-Wreserved-identifier"
+#endif
+// Big mess created because of the way spdlog is organizing its source code
+// based on header only builds vs library builds. The issue is that spdlog
+// places the template definitions in a separate file and explicitly
+// instantiates them, so we have no problem at link, but we do have a problem
+// with clang (rightfully) complaining that the template definitions are not
+// available when the template needs to be instantiated here.
+#pragma clang diagnostic ignored "-Wundefined-func-template"
+#endif // __clang__
+
+
+#include <common/unicode/encoding_utf.h>
+#include <common/unicode/utf.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using nowide::utf::code_point;
+using nowide::utf::illegal;
+using nowide::utf::incomplete;
+
+namespace {
+
+/// Straightforward decoder following table 3-7 of the Unicode standard
+/// (well-formed UTF-8 byte sequences), used as a reference. Returns the
+/// length of the sequence, 0 if [p, e) is a proper prefix of a well-formed
+/// sequence, and -1 if it is ill-formed.
+auto reference_decode(unsigned char const *p, unsigned char const *e,
+                      code_point &c) -> int {
+  struct row {
+    unsigned char lead_min, lead_max, second_min, second_max;
+    int length;
+  };
+  static const row rows[] = {
+      {0x00, 0x7F, 0, 0, 1},       {0xC2, 0xDF, 0x80, 0xBF, 2},
+      {0xE0, 0xE0, 0xA0, 0xBF, 3}, {0xE1, 0xEC, 0x80, 0xBF, 3},
+      {0xED, 0xED, 0x80, 0x9F, 3}, {0xEE, 0xEF, 0x80, 0xBF, 3},
+      {0xF0, 0xF0, 0x90, 0xBF, 4}, {0xF1, 0xF3, 0x80, 0xBF, 4},
+      {0xF4, 0xF4, 0x80, 0x8F, 4}};
+  for (row const &r : rows) {
+    if (*p < r.lead_min || *p > r.lead_max) {
+      continue;
+    }
+    c = r.length == 1 ? *p : *p & (0xFFU >> (r.length + 1));
+    for (int i = 1; i < r.length; ++i) {
+      if (p + i == e) {
+        return 0;
+      }
+      unsigned char lo = i == 1 ? r.second_min : 0x80;
+      unsigned char hi = i == 1 ? r.second_max : 0xBF;
+      if (p[i] < lo || p[i] > hi) {
+        return -1;
+      }
+      c = (c << 6) | (p[i] & 0x3FU);
+    }
+    return r.length;
+  }
+  return -1;
+}
+
+/// Number of disagreements of the decoder with the reference on [p, e).
+template <typename Decoder>
+auto check(unsigned char const *p, unsigned char const *e, Decoder decode)
+    -> int {
+  code_point expected = 0;
+  int length = reference_decode(p, e, expected);
+  auto first = reinterpret_cast<char const *>(p);
+  char const *it = first;
+  code_point c = decode(it, reinterpret_cast<char const *>(e));
+  if (length > 0) {
+    return c == expected && it == first + length ? 0 : 1;
+  }
+  if (length == 0) {
+    return c == incomplete ? 0 : 1;
+  }
+  return c == illegal || c == incomplete ? 0 : 1;
+}
+
+struct branchy {
+  auto operator()(char const *&p, char const *e) const -> code_point {
+    return nowide::utf::utf_traits<char>::decode(p, e);
+  }
+};
+
+struct dfa {
+  auto operator()(char const *&p, char const *e) const -> code_point {
+    return nowide::utf::details::decode_utf8_dfa(p, e);
+  }
+};
+
+template <typename Decoder>
+auto check_all(Decoder decode) -> int {
+  int failures = 0;
+  unsigned char buf[4];
+  for (unsigned b0 = 0; b0 < 256; ++b0) {
+    buf[0] = static_cast<unsigned char>(b0);
+    failures += check(buf, buf + 1, decode);
+    for (unsigned b1 = 0x70; b1 < 0xD0; ++b1) {
+      buf[1] = static_cast<unsigned char>(b1);
+      failures += check(buf, buf + 2, decode);
+      for (unsigned b2 = 0x70; b2 < 0xD0; ++b2) {
+        buf[2] = static_cast<unsigned char>(b2);
+        failures += check(buf, buf + 3, decode);
+        if (b0 < 0xEF || b0 > 0xF5 || (b2 & 0x0F) != 0) {
+          continue;
+        }
+        for (unsigned b3 : {0x7Fu, 0x80u, 0x9Fu, 0xBFu, 0xC0u}) {
+          buf[3] = static_cast<unsigned char>(b3);
+          failures += check(buf, buf + 4, decode);
+        }
+      }
+    }
+  }
+  return failures;
+}
+
+auto mixed_text() -> std::string {
+  // Cyrillic, CJK, emoji and ASCII, in short runs
+  std::string text;
+  while (text.size() < (1U << 20)) {
+    text += "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 ";
+    text += "\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c ";
+    text += "\xf0\x9f\x98\x80\xf0\x9f\x9a\x80 ok ";
+  }
+  return text;
+}
+
+template <typename Decoder>
+auto decode_all(std::string const &text, Decoder decode) -> code_point {
+  code_point sum = 0;
+  char const *p = text.data();
+  char const *e = p + text.size();
+  while (p != e) {
+    sum += decode(p, e);
+  }
+  return sum;
+}
+
+}  // namespace
+
+TEST_CASE("Unicode / utf8 decoder / conformance",
+          "[common][unicode][utf8_decoder]") {
+  REQUIRE(check_all(branchy()) == 0);
+  REQUIRE(check_all(dfa()) == 0);
+}
+
+TEST_CASE("Unicode / utf8 decoder / mixed text",
+          "[common][unicode][utf8_decoder]") {
+  std::string text = mixed_text();
+  REQUIRE(decode_all(text, dfa()) == decode_all(text, branchy()));
+}
+
+// Throughput of both decoders on mixed script text. The test cases are hidden;
+// run them with `asap_common_test "[utf8_decoder][benchmark]"`, under
+// `perf stat -e branches,branch-misses` to compare mispredictions.
+// utf_traits<char>::decode() uses the DFA when ASAP_UNICODE_DFA_DECODER is ON.
+
+TEST_CASE("Unicode / utf8 decoder / benchmark branchy",
+          "[.][utf8_decoder][benchmark]") {
+  std::string text = mixed_text();
+#if defined(CATCH_CONFIG_ENABLE_BENCHMARKING)
+  BENCHMARK("branchy decoder, 1 MiB") { return decode_all(text, branchy()); };
+#else
+  code_point sum = 0;
+  for (int i = 0; i < 200; ++i) {
+    sum += decode_all(text, branchy());
+  }
+  REQUIRE(sum != 0);
+#endif
+}
+
+TEST_CASE("Unicode / utf8 decoder / benchmark dfa",
+          "[.][utf8_decoder][benchmark]") {
+  std::string text = mixed_text();
+#if defined(CATCH_CONFIG_ENABLE_BENCHMARKING)
+  BENCHMARK("DFA decoder, 1 MiB") { return decode_all(text, dfa()); };
+#else
+  code_point sum = 0;
+  for (int i = 0; i < 200; ++i) {
+    sum += decode_all(text, dfa());
+  }
+  REQUIRE(sum != 0);
+#endif
+}
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif // __clang__